@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "batch.h"
+#include "game.h"
+#include "parameters.h"
+#include "thread_pool.h"
+
+my_uint_t run_batch(
+                      const solver_context_t &context,
+                      const string &targets_filename,
+                      const string &results_filename
+                   )
+{
+   const word_list_t &answers{context.answers};
+
+   vector<string> targets;
+
+   if (targets_filename.empty())
+      answers.for_each([&](my_uint_t id){ targets.push_back(answers.word(id)); });
+   else
+   {
+      ifstream targets_file{targets_filename};
+
+      if (! targets_file)
+      {
+         stringstream ss;
+
+         ss << targets_filename << " is missing";
+         throw runtime_error(ss.str());
+      }
+
+      string target;
+
+      while (getline(targets_file, target))
+      {
+         if (! answers.contains(target))
+         {
+            stringstream ss;
+
+            ss << "The target word " << target << " is not an allowed answer word!";
+            throw runtime_error(ss.str());
+         }
+
+         targets.push_back(target);
+      }
+   }
+
+   const auto start_time{chrono::steady_clock::now()};
+
+   // One game per task. Games share the word lists and pattern matrix;
+   // their entropy calculations run on the same pool as the games.
+   vector<my_uint_t> rounds(targets.size());
+
+   thread_pool().parallel_for(
+                                0,
+                                targets.size(),
+                                1,
+                                [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                {
+                                   // Discard the usual per-round output
+                                   ostream no_output{nullptr};
+
+                                   for (my_uint_t i{first}; i < last; ++i)
+                                   {
+                                      game_t game{context, no_output};
+
+                                      rounds[i] = play_game(game, targets[i]);
+                                   }
+                                }
+                             );
+
+   const chrono::duration<double> elapsed{chrono::steady_clock::now() - start_time};
+
+   // Sort the same way as "sort -n -r -k 2" did: most rounds first,
+   // then reverse alphabetical order.
+   vector<my_uint_t> order(targets.size());
+
+   for (my_uint_t i{0}; i < order.size(); ++i)
+      order[i] = i;
+
+   sort(
+          order.begin(),
+          order.end(),
+          [&](my_uint_t a, my_uint_t b)
+          {
+             if (rounds[a] != rounds[b])
+                return rounds[a] > rounds[b];
+
+             return targets[a] > targets[b];
+          }
+       );
+
+   ofstream results_file{results_filename};
+   vector<my_uint_t> histogram(parameters.rounds + 2, 0);
+   my_uint_t total_rounds{0};
+   my_uint_t failures{0};
+
+   for (my_uint_t i : order)
+   {
+      results_file << targets[i] << " ";
+
+      if (rounds[i] > parameters.rounds)
+      {
+         results_file << "FAILURE!!!" << endl;
+         ++failures;
+      }
+      else
+      {
+         results_file << rounds[i] << endl;
+         total_rounds += rounds[i];
+      }
+
+      ++histogram[rounds[i]];
+   }
+
+   results_file.close();
+
+   if (! results_file)
+   {
+      stringstream ss;
+
+      ss << "Unable to write " << results_filename;
+      throw runtime_error(ss.str());
+   }
+
+   cout << "Games played: " << targets.size() << endl;
+   cout << endl;
+   cout << "Rounds  Games" << endl;
+
+   for (my_uint_t round{1}; round <= parameters.rounds; ++round)
+      cout << setw(6) << round << "  " << setw(5) << histogram[round] << endl;
+
+   cout << "Failed  " << setw(5) << failures << endl;
+   cout << endl;
+
+   if (targets.size() > failures)
+   {
+      cout << "Average rounds: "
+           << fixed
+           << setprecision(6)
+           << total_rounds / static_cast<double>(targets.size() - failures)
+           << endl;
+   }
+
+   if (context.guess_cache != nullptr)
+      context.guess_cache->print_stats(cout);
+
+   cout << "Results written to " << results_filename << endl;
+
+   cout << "Elapsed time: "
+        << fixed
+        << setprecision(2)
+        << elapsed.count()
+        << " s"
+        << endl;
+
+   cout << endl;
+
+   return failures;
+}
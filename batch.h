@@ -0,0 +1,24 @@
+#ifndef BATCH_INCLUDED
+#define BATCH_INCLUDED
+
+#include <string>
+
+using namespace std;
+
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// Play a game against every word in targets_filename (every allowed
+// answer if it is empty), in parallel, within this process. Games
+// share the context's guess cache, so each game state is only solved
+// once. The rounds
+// each game took are written to results_filename in the same format
+// test_all used to produce, and a histogram of rounds and the mean are
+// printed. Returns the number of games that were not solved.
+my_uint_t run_batch(
+                      const solver_context_t &context,
+                      const string &targets_filename,
+                      const string &results_filename
+                   );
+
+#endif
@@ -0,0 +1,1100 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "candidate_columns.h"
+#include "dictionary.h"
+#include "filter.h"
+#include "game.h"
+#include "guess_cache.h"
+#include "opener_table.h"
+#include "parameters.h"
+#include "pattern_kernel.h"
+#include "pattern_matrix.h"
+#include "scoring_policy.h"
+#include "solver_context.h"
+#include "thread_pool.h"
+#include "tools.h"
+#include "type_aliases.h"
+
+// Micro- and macro-benchmarks of the solver, with a check that every
+// game in the checked-in results files still takes the same number of
+// rounds.
+//
+// The global thread pool is sized once per process, so each thread
+// count is measured in a child process of its own. Results are written
+// as JSON and compared against a baseline written the same way; any
+// benchmark slower than its baseline by more than the tolerance, or
+// any game whose round count has changed, makes the run fail.
+
+namespace
+{
+   struct bench_options_t
+   {
+      string baseline_filename{"benchmarks/baseline.json"};
+      string output_filename{"bench_results.json"};
+      double tolerance{0.25};
+      my_uint_t max_threads{thread::hardware_concurrency()};
+   };
+
+   // One measurement: seconds per operation for microbenchmarks,
+   // seconds per run for the macrobenchmarks
+   struct result_t
+   {
+      string name;
+      my_uint_t threads;
+      double seconds;
+   };
+
+   // What one child process measures
+   struct job_t
+   {
+      string label;
+      string guesses_filename;
+      string answers_filename;
+      string results_filename;
+      my_uint_t threads;
+
+      // Single-threaded benchmarks are only worth running once
+      bool micro;
+
+      // Entropy scoring over the word lists, at every thread count
+      bool entropies;
+
+      // Not a benchmark: check the pattern of every guess against
+      // every answer from pattern_kernel_t against compare()
+      bool check_patterns;
+   };
+
+   bool parse_bench_options(int argc, char *argv[], bench_options_t &options);
+
+   vector<job_t> make_jobs(my_uint_t max_threads);
+
+   // Run job in a child process, adding its results. Returns false if
+   // the child failed, which includes changed round counts.
+   bool run_job(const job_t &job, vector<result_t> &results);
+
+   void run_benchmarks(const job_t &job, ostream &results_out);
+
+   // Throw if pattern_kernel_t gets the pattern of any guess against
+   // any answer wrong, taking compare() to be right
+   void check_patterns(const pattern_matrix_t &pattern_matrix, const vector<string> &answer_list);
+
+   // The best of repetitions timings of run, each preceded by an untimed
+   // call to setup
+   double best_time(
+                      my_uint_t repetitions,
+                      const function<void()> &setup,
+                      const function<void()> &run
+                   );
+
+   // Play every game listed in results_filename, returning how long it
+   // took and adding one line per game that took a different number of
+   // rounds to mismatches
+   double replay_results(
+                           const solver_context_t &context,
+                           const string &results_filename,
+                           vector<string> &mismatches
+                        );
+
+   void write_results(const vector<result_t> &results, const string &filename);
+   vector<result_t> read_results(const string &filename);
+
+   // Returns the number of regressions
+   my_uint_t compare_results(
+                               const vector<result_t> &baseline,
+                               const vector<result_t> &results,
+                               double tolerance
+                            );
+}
+
+int main(int argc, char *argv[])
+{
+   bench_options_t options;
+
+   if (! parse_bench_options(argc, argv, options))
+      return 255;
+
+   vector<result_t> results;
+   bool failed{false};
+
+   for (const job_t &job : make_jobs(options.max_threads))
+   {
+      cout << "Benchmarking " << job.label << " with " << job.threads << " thread(s)" << endl;
+
+      if (! run_job(job, results))
+         failed = true;
+   }
+
+   cout << endl;
+
+   write_results(results, options.output_filename);
+
+   cout << "Results written to " << options.output_filename << endl;
+   cout << endl;
+
+   if (! options.baseline_filename.empty())
+   {
+      const vector<result_t> baseline{read_results(options.baseline_filename)};
+
+      if (compare_results(baseline, results, options.tolerance) > 0)
+         failed = true;
+   }
+
+   if (failed)
+   {
+      cout << "BENCHMARK FAILED!!!" << endl;
+      cout << endl;
+
+      return 1;
+   }
+
+   return 0;
+}
+
+namespace
+{
+   bool parse_bench_options(int argc, char *argv[], bench_options_t &options)
+   {
+      for (int i{1}; i < argc; ++i)
+      {
+         const string arg{argv[i]};
+
+         if (i + 1 < argc && arg == "--baseline")
+            options.baseline_filename = argv[++i];
+         else if (i + 1 < argc && arg == "--output")
+            options.output_filename = argv[++i];
+         else if (i + 1 < argc && arg == "--tolerance")
+         {
+            char *end;
+
+            options.tolerance = strtod(argv[++i], &end);
+
+            if (*end != '\0' || options.tolerance < 0)
+            {
+               cout << "Invalid tolerance: " << argv[i] << endl;
+               cout << endl;
+
+               return false;
+            }
+         }
+         else if (i + 1 < argc && arg == "--max-threads")
+         {
+            char *end;
+
+            options.max_threads = strtoul(argv[++i], &end, 10);
+
+            if (*end != '\0' || options.max_threads == 0)
+            {
+               cout << "Invalid thread count: " << argv[i] << endl;
+               cout << endl;
+
+               return false;
+            }
+         }
+         else
+         {
+            cout << "Usage: " << argv[0] << " [options]" << endl;
+            cout << endl;
+            cout << "   --baseline <file>    Compare against this baseline, \"\" for none" << endl;
+            cout << "                        (default benchmarks/baseline.json)" << endl;
+            cout << "   --output <file>      Write results here (default bench_results.json)" << endl;
+            cout << "   --tolerance <x>      Fail if anything is more than this fraction slower" << endl;
+            cout << "                        than its baseline (default 0.25)" << endl;
+            cout << "   --max-threads <n>    Sweep thread counts up to n (default: all cores)" << endl;
+            cout << endl;
+
+            return false;
+         }
+      }
+
+      options.max_threads = max(options.max_threads, my_uint_t{1});
+
+      return true;
+   }
+
+   vector<job_t> make_jobs(my_uint_t max_threads)
+   {
+      const string wordle_guesses{"wordle-allowed-guesses.txt"};
+      const string wordle_answers{"wordle-answers-alphabetical.txt"};
+
+      vector<job_t> jobs;
+
+      // Thread counts 1, 2, 4, ... and max_threads itself
+      for (my_uint_t threads{1}; ; threads = min(threads * 2, max_threads))
+      {
+         jobs.push_back(
+                          {
+                             "Wordle",
+                             wordle_guesses,
+                             wordle_answers,
+                             "results_Wordle.txt",
+                             threads,
+                             threads == 1,
+                             true,
+                             threads == 1
+                          }
+                       );
+
+         if (threads == max_threads)
+            break;
+      }
+
+      jobs.push_back(
+                       {
+                          "Wordmaster",
+                          "wordmaster-allowed-guesses.txt",
+                          "wordmaster-answers-alphabetical.txt",
+                          "results_Wordmaster.txt",
+                          max_threads,
+                          false,
+                          false,
+                          true
+                       }
+                    );
+
+      return jobs;
+   }
+
+   bool run_job(const job_t &job, vector<result_t> &results)
+   {
+      int fds[2];
+
+      if (pipe(fds) != 0)
+         throw runtime_error("Unable to create a pipe");
+
+      // Nothing may be buffered when the child starts, or it would be
+      // written twice
+      cout.flush();
+
+      const pid_t pid{fork()};
+
+      if (pid < 0)
+         throw runtime_error("Unable to fork");
+
+      if (pid == 0)
+      {
+         close(fds[0]);
+
+         int status{0};
+
+         try
+         {
+            stringstream results_out;
+
+            run_benchmarks(job, results_out);
+
+            const string text{results_out.str()};
+
+            if (write(fds[1], text.data(), text.size()) != static_cast<ssize_t>(text.size()))
+               status = 3;
+         }
+         catch (const exception &e)
+         {
+            cout << "   " << e.what() << endl;
+            status = 2;
+         }
+
+         cout.flush();
+         _exit(status);
+      }
+
+      close(fds[1]);
+
+      // Each line is "name threads seconds"
+      string text;
+      char buffer[4096];
+      ssize_t count;
+
+      while ((count = read(fds[0], buffer, sizeof(buffer))) != 0)
+      {
+         if (count < 0)
+         {
+            if (errno == EINTR)
+               continue;
+
+            break;
+         }
+
+         text.append(buffer, count);
+      }
+
+      close(fds[0]);
+
+      int status;
+
+      while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+      {
+      }
+
+      stringstream ss{text};
+      result_t result;
+
+      while (ss >> result.name >> result.threads >> result.seconds)
+         results.push_back(result);
+
+      return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+   }
+
+   void run_benchmarks(const job_t &job, ostream &results_out)
+   {
+      parameters.allowed_guesses_filename = job.guesses_filename;
+      parameters.allowed_answers_filename = job.answers_filename;
+      parameters.threads_limit = job.threads;
+
+      auto report{
+                    [&](const string &name, double seconds)
+                    {
+                       cout << "   "
+                            << left
+                            << setw(30)
+                            << name
+                            << right
+                            << scientific
+                            << setprecision(3)
+                            << seconds
+                            << " s"
+                            << endl;
+
+                       results_out << name
+                                   << " "
+                                   << job.threads
+                                   << " "
+                                   << setprecision(6)
+                                   << scientific
+                                   << seconds
+                                   << endl;
+                    }
+                 };
+
+      dictionary_t dictionary;
+
+      if (job.micro)
+         report("load_words", best_time(3, [](){}, [&](){ load_words(dictionary); }));
+      else
+         load_words(dictionary);
+
+      if (job.micro)
+      {
+         const string image_filename{"bench_dictionary.tmp"};
+         dictionary_t image;
+         string guesses_source;
+         string answers_source;
+
+         dictionary.save_image(image_filename, "", "");
+
+         report(
+                  "load_dictionary_image",
+                  best_time(
+                              3,
+                              [](){},
+                              [&](){ image.load_image(image_filename, guesses_source, answers_source); }
+                           )
+               );
+
+         remove(image_filename.c_str());
+      }
+
+      parameters.set_word_length(dictionary.word_length());
+
+      const word_list_t all_words{dictionary, word_kind_t::guesses};
+      const word_list_t answers{dictionary, word_kind_t::answers};
+
+      pattern_matrix_t pattern_matrix;
+
+      pattern_matrix.load(dictionary);
+
+      const filter_index_t filter_index{pattern_matrix};
+
+      opener_table_t opener_table{pattern_matrix, filter_index, all_words, answers};
+
+      // Built or read up front, so that the replays only time games
+      if (USE_OPENER_TABLE)
+         opener_table.best();
+
+      const solver_context_t context{
+                                       pattern_matrix,
+                                       filter_index,
+                                       all_words,
+                                       answers,
+                                       nullptr,
+                                       {},
+                                       nullptr,
+                                       USE_OPENER_TABLE ? &opener_table : nullptr
+                                    };
+
+      vector<string> answer_list;
+
+      for (my_uint_t i{0}; i < dictionary.num_answers(); ++i)
+         answer_list.push_back(dictionary.answer_word(i));
+
+      if (job.check_patterns)
+         check_patterns(pattern_matrix, answer_list);
+
+      // Games after their first and second guesses, for a spread of targets
+      vector<game_t> round_2_games;
+      vector<game_t> round_3_games;
+      ostream no_output{nullptr};
+
+      if (job.micro || job.entropies)
+      {
+         constexpr my_uint_t TARGET_STRIDE{50};
+
+         round_2_games.reserve(answer_list.size() / TARGET_STRIDE + 1);
+         round_3_games.reserve(answer_list.size() / TARGET_STRIDE + 1);
+
+         for (my_uint_t i{0}; i < answer_list.size(); i += TARGET_STRIDE)
+         {
+            game_t game{context, no_output};
+
+            for (my_uint_t round{1}; round <= 2 && ! game.solved(); ++round)
+            {
+               const string guess{game.next_guess()};
+
+               game.submit(guess, game.result_for(answer_list[i], guess));
+
+               if (game.solved() || game.possible_answers().size() <= 1)
+                  break;
+
+               (round == 1 ? round_2_games : round_3_games).push_back(game);
+            }
+         }
+      }
+
+      if (job.micro)
+      {
+         // Every answer against a spread of guesses
+         vector<string> guesses;
+
+         for (my_uint_t i{0}; i < dictionary.num_guesses(); i += dictionary.num_guesses() / 64 + 1)
+            guesses.push_back(dictionary.guess_word(i));
+
+         // Keeps the results from being optimized away
+         volatile char sink;
+
+         const double compare_time{
+                                     best_time(
+                                                 5,
+                                                 [](){},
+                                                 [&]()
+                                                 {
+                                                    for (const string &guess : guesses)
+                                                    {
+                                                       for (const string &answer : answer_list)
+                                                          sink = compare(answer, guess)[0];
+                                                    }
+                                                 }
+                                              )
+                                  };
+
+         report("compare", compare_time / (guesses.size() * answer_list.size()));
+
+         // The same, a whole row of answers at a time
+         vector<uint32_t> all_answers(answer_list.size());
+
+         iota(all_answers.begin(), all_answers.end(), 0);
+
+         const letter_columns_t answer_letters{pattern_matrix.answer_columns(all_answers)};
+         vector<pattern_t> row(answer_list.size());
+
+         const double batch_time{
+                                   best_time(
+                                               5,
+                                               [](){},
+                                               [&]()
+                                               {
+                                                  with_word_length(
+                                                                     parameters.word_length,
+                                                                     [&]<my_uint_t WORD_LENGTH>()
+                                                                     {
+                                                                        for (const string &guess : guesses)
+                                                                        {
+                                                                           pattern_kernel_t<WORD_LENGTH>::compute_patterns(
+                                                                                                                             guess.data(),
+                                                                                                                             answer_letters,
+                                                                                                                             0,
+                                                                                                                             row.size(),
+                                                                                                                             row.data()
+                                                                                                                          );
+
+                                                                           sink = row[0];
+                                                                        }
+                                                                     }
+                                                                  );
+                                               }
+                                            )
+                                };
+
+         report("compare_batch", batch_time / (guesses.size() * answer_list.size()));
+
+         // The first round's filtering, for a spread of targets
+         const string first_guess{game_t{context, no_output}.next_guess()};
+         vector<string> results;
+
+         for (my_uint_t i{0}; i < answer_list.size(); i += answer_list.size() / 64 + 1)
+            results.push_back(compare(answer_list[i], first_guess));
+
+         vector<filter_t> filters;
+         vector<word_list_t> filtered;
+
+         const double filter_time{
+                                    best_time(
+                                                5,
+                                                [&]()
+                                                {
+                                                   filters.clear();
+
+                                                   for (my_uint_t i{0}; i < results.size(); ++i)
+                                                      filters.emplace_back(filter_index);
+
+                                                   filtered.assign(results.size(), answers);
+                                                },
+                                                [&]()
+                                                {
+                                                   for (my_uint_t i{0}; i < results.size(); ++i)
+                                                      filters[i].filter(filtered[i], first_guess, results[i]);
+                                                }
+                                             )
+                                 };
+
+         report("filter_round_1", filter_time / results.size());
+      }
+
+      if (job.entropies)
+      {
+         entropy_words_map_t entropies;
+
+         report(
+                  "entropies_round_1",
+                  best_time(
+                              10,
+                              [](){},
+                              [&](){ calculate_entropies(pattern_matrix, all_words, answers, entropies, 1); }
+                           )
+               );
+
+         for (const auto &[name, games] : {
+                                              pair{"entropies_round_2", &round_2_games},
+                                              pair{"entropies_round_3", &round_3_games}
+                                           })
+         {
+            if (games->empty())
+               continue;
+
+            const double seconds{
+                                   best_time(
+                                               5,
+                                               [](){},
+                                               [&]()
+                                               {
+                                                  for (const game_t &game : *games)
+                                                  {
+                                                     calculate_entropies(
+                                                                           pattern_matrix,
+                                                                           game.allowed_guesses(),
+                                                                           game.possible_answers(),
+                                                                           entropies,
+                                                                           1
+                                                                        );
+                                                  }
+                                               }
+                                            )
+                                };
+
+            report(name, seconds / games->size());
+
+            // The same, as games score them: compacting the candidates'
+            // columns first, and then reading only those
+            vector<candidate_columns_t> columns;
+
+            const double compacted_seconds{
+                                             best_time(
+                                                         5,
+                                                         [&]()
+                                                         {
+                                                            columns.clear();
+
+                                                            for (my_uint_t i{0}; i < games->size(); ++i)
+                                                               columns.emplace_back(pattern_matrix);
+                                                         },
+                                                         [&]()
+                                                         {
+                                                            for (my_uint_t i{0}; i < games->size(); ++i)
+                                                            {
+                                                               const game_t &game{(*games)[i]};
+
+                                                               columns[i].compact(game.possible_answers().ids());
+
+                                                               calculate_entropies(
+                                                                                     pattern_matrix,
+                                                                                     game.allowed_guesses(),
+                                                                                     game.possible_answers(),
+                                                                                     entropies,
+                                                                                     1,
+                                                                                     &columns[i]
+                                                                                  );
+                                                            }
+                                                         }
+                                                      )
+                                          };
+
+            report(string(name) + "_compacted", compacted_seconds / games->size());
+         }
+      }
+
+      // Round 2 again under each of the other scoring policies, which
+      // all come from the same histogram pass as entropy
+      if (job.micro && ! round_2_games.empty())
+      {
+         entropy_words_map_t entropies;
+
+         for (const auto &[name, text] : {
+                                            pair{"expected_size", "expected-size"},
+                                            pair{"worst_case", "worst-case"},
+                                            pair{"buckets", "buckets"}
+                                         })
+         {
+            scoring_policy_t policy;
+
+            parse_scoring_policy(text, policy);
+
+            const double seconds{
+                                   best_time(
+                                               5,
+                                               [](){},
+                                               [&]()
+                                               {
+                                                  for (const game_t &game : round_2_games)
+                                                  {
+                                                     calculate_entropies(
+                                                                           pattern_matrix,
+                                                                           game.allowed_guesses(),
+                                                                           game.possible_answers(),
+                                                                           entropies,
+                                                                           1,
+                                                                           nullptr,
+                                                                           policy
+                                                                        );
+                                                  }
+                                               }
+                                            )
+                                };
+
+            report(string("scores_round_2_") + name, seconds / round_2_games.size());
+         }
+      }
+
+      // Rounds 1 and 2 again without the matrix, as if it did not fit
+      // a memory budget just big enough for a tile per thread, checking
+      // that the patterns computed tile by tile pick the same guesses
+      if (job.micro)
+      {
+         pattern_matrix_t tiled_matrix;
+
+         parameters.memory_budget = 2 * num_threads() * PATTERN_TILE_BYTES;
+         tiled_matrix.load(dictionary);
+         parameters.memory_budget = 0;
+
+         if (tiled_matrix.storage() == pattern_storage_t::tiled)
+         {
+            entropy_words_map_t entropies;
+            entropy_words_map_t expected;
+
+            report(
+                     "entropies_round_1_tiled",
+                     best_time(
+                                 3,
+                                 [](){},
+                                 [&](){ calculate_entropies(tiled_matrix, all_words, answers, entropies, 1); }
+                              )
+                  );
+
+            calculate_entropies(pattern_matrix, all_words, answers, expected, 1);
+
+            if (entropies != expected)
+               throw runtime_error("Tiled scoring picked a different first guess");
+
+            if (! round_2_games.empty())
+            {
+               const double seconds{
+                                      best_time(
+                                                  3,
+                                                  [](){},
+                                                  [&]()
+                                                  {
+                                                     for (const game_t &game : round_2_games)
+                                                     {
+                                                        calculate_entropies(
+                                                                              tiled_matrix,
+                                                                              game.allowed_guesses(),
+                                                                              game.possible_answers(),
+                                                                              entropies,
+                                                                              1
+                                                                           );
+                                                     }
+                                                  }
+                                               )
+                                   };
+
+               report("entropies_round_2_tiled", seconds / round_2_games.size());
+
+               for (const game_t &game : round_2_games)
+               {
+                  calculate_entropies(
+                                        tiled_matrix,
+                                        game.allowed_guesses(),
+                                        game.possible_answers(),
+                                        entropies,
+                                        1
+                                     );
+
+                  calculate_entropies(
+                                        pattern_matrix,
+                                        game.allowed_guesses(),
+                                        game.possible_answers(),
+                                        expected,
+                                        1
+                                     );
+
+                  if (entropies != expected)
+                     throw runtime_error("Tiled scoring picked a different guess in round 2");
+               }
+            }
+         }
+      }
+
+      vector<string> mismatches;
+
+      report("replay_" + job.label, replay_results(context, job.results_filename, mismatches));
+
+      if (! mismatches.empty())
+      {
+         cout << "   Round counts differ from " << job.results_filename << ":" << endl;
+
+         for (const string &mismatch : mismatches)
+            cout << "      " << mismatch << endl;
+
+         stringstream ss;
+
+         ss << mismatches.size() << " games changed";
+         throw runtime_error(ss.str());
+      }
+   }
+
+   void check_patterns(const pattern_matrix_t &pattern_matrix, const vector<string> &answer_list)
+   {
+      vector<uint32_t> all_answers(answer_list.size());
+
+      iota(all_answers.begin(), all_answers.end(), 0);
+
+      const letter_columns_t answer_letters{pattern_matrix.answer_columns(all_answers)};
+      vector<pattern_t> row(answer_list.size());
+
+      with_word_length(
+                         parameters.word_length,
+                         [&]<my_uint_t WORD_LENGTH>()
+                         {
+                            for (my_uint_t g{0}; g < pattern_matrix.num_guesses(); ++g)
+                            {
+                               const string guess{pattern_matrix.guess_word(g)};
+
+                               pattern_kernel_t<WORD_LENGTH>::compute_patterns(
+                                                                                 guess.data(),
+                                                                                 answer_letters,
+                                                                                 0,
+                                                                                 row.size(),
+                                                                                 row.data()
+                                                                              );
+
+                               for (my_uint_t a{0}; a < row.size(); ++a)
+                               {
+                                  const string expected{compare(answer_list[a], guess)};
+
+                                  if (row[a] != encode_result(expected))
+                                  {
+                                     stringstream ss;
+
+                                     ss << "Pattern kernel gives "
+                                        << decode_pattern(row[a])
+                                        << " for guess "
+                                        << guess
+                                        << " against answer "
+                                        << answer_list[a]
+                                        << ", not "
+                                        << expected;
+
+                                     throw runtime_error(ss.str());
+                                  }
+                               }
+                            }
+                         }
+                      );
+   }
+
+   double best_time(
+                      my_uint_t repetitions,
+                      const function<void()> &setup,
+                      const function<void()> &run
+                   )
+   {
+      double best{numeric_limits<double>::max()};
+
+      for (my_uint_t i{0}; i < repetitions; ++i)
+      {
+         setup();
+
+         const auto start_time{chrono::steady_clock::now()};
+
+         run();
+
+         const chrono::duration<double> elapsed{chrono::steady_clock::now() - start_time};
+
+         best = min(best, elapsed.count());
+      }
+
+      return best;
+   }
+
+   double replay_results(
+                           const solver_context_t &context,
+                           const string &results_filename,
+                           vector<string> &mismatches
+                        )
+   {
+      ifstream results_file{results_filename};
+
+      if (! results_file)
+      {
+         stringstream ss;
+
+         ss << results_filename << " is missing";
+         throw runtime_error(ss.str());
+      }
+
+      // Each line is "target rounds" or "target FAILURE!!!"
+      vector<string> targets;
+      vector<my_uint_t> expected_rounds;
+      string target;
+      string rounds;
+
+      while (results_file >> target >> rounds)
+      {
+         targets.push_back(target);
+         expected_rounds.push_back(
+                                     rounds == "FAILURE!!!" ?
+                                     parameters.rounds + 1 :
+                                     stoul(rounds)
+                                  );
+      }
+
+      // Games share a cache of best guesses, as in batch mode. It starts
+      // out empty so that every game state is solved once.
+      guess_cache_t guess_cache;
+      solver_context_t replay_context{context};
+
+      replay_context.guess_cache = &guess_cache;
+
+      vector<my_uint_t> actual_rounds(targets.size());
+
+      const auto start_time{chrono::steady_clock::now()};
+
+      thread_pool().parallel_for(
+                                   0,
+                                   targets.size(),
+                                   1,
+                                   [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                   {
+                                      ostream no_output{nullptr};
+
+                                      for (my_uint_t i{first}; i < last; ++i)
+                                      {
+                                         game_t game{replay_context, no_output};
+
+                                         actual_rounds[i] = play_game(game, targets[i]);
+                                      }
+                                   }
+                                );
+
+      const chrono::duration<double> elapsed{chrono::steady_clock::now() - start_time};
+
+      for (my_uint_t i{0}; i < targets.size(); ++i)
+      {
+         if (actual_rounds[i] != expected_rounds[i])
+         {
+            stringstream ss;
+
+            ss << targets[i]
+               << ": "
+               << actual_rounds[i]
+               << " rounds, expected "
+               << expected_rounds[i];
+
+            mismatches.push_back(ss.str());
+         }
+      }
+
+      return elapsed.count();
+   }
+
+   void write_results(const vector<result_t> &results, const string &filename)
+   {
+      ofstream file{filename};
+
+      // One benchmark per line, which read_results() relies on
+      file << "{" << endl;
+      file << "   \"benchmarks\": [" << endl;
+
+      for (my_uint_t i{0}; i < results.size(); ++i)
+      {
+         file << "      {\"name\": \""
+              << results[i].name
+              << "\", \"threads\": "
+              << results[i].threads
+              << ", \"seconds\": "
+              << setprecision(6)
+              << scientific
+              << results[i].seconds
+              << "}"
+              << (i + 1 < results.size() ? "," : "")
+              << endl;
+      }
+
+      file << "   ]" << endl;
+      file << "}" << endl;
+
+      file.close();
+
+      if (! file)
+      {
+         stringstream ss;
+
+         ss << "Unable to write " << filename;
+         throw runtime_error(ss.str());
+      }
+   }
+
+   vector<result_t> read_results(const string &filename)
+   {
+      ifstream file{filename};
+
+      if (! file)
+      {
+         stringstream ss;
+
+         ss << filename << " is missing";
+         throw runtime_error(ss.str());
+      }
+
+      const regex line_regex{
+                               R"re(\{"name": "([^"]+)", "threads": ([0-9]+), "seconds": ([-+.0-9eE]+)\})re"
+                            };
+
+      vector<result_t> results;
+      string line;
+      smatch match;
+
+      while (getline(file, line))
+      {
+         if (regex_search(line, match, line_regex))
+            results.push_back({match[1], stoul(match[2]), stod(match[3])});
+      }
+
+      return results;
+   }
+
+   my_uint_t compare_results(
+                               const vector<result_t> &baseline,
+                               const vector<result_t> &results,
+                               double tolerance
+                            )
+   {
+      map<pair<string, my_uint_t>, double> baseline_seconds;
+
+      for (const result_t &result : baseline)
+         baseline_seconds[{result.name, result.threads}] = result.seconds;
+
+      my_uint_t regressions{0};
+
+      cout << left
+           << setw(30) << "Benchmark"
+           << right
+           << setw(8) << "Threads"
+           << setw(12) << "Baseline"
+           << setw(12) << "Current"
+           << setw(9) << "Change"
+           << endl;
+
+      for (const result_t &result : results)
+      {
+         cout << left
+              << setw(30) << result.name
+              << right
+              << setw(8) << result.threads
+              << scientific
+              << setprecision(3);
+
+         const auto iter{baseline_seconds.find({result.name, result.threads})};
+
+         if (iter == baseline_seconds.cend())
+         {
+            cout << setw(12) << "-" << setw(12) << result.seconds << endl;
+            continue;
+         }
+
+         const double change{result.seconds / iter->second - 1};
+
+         cout << setw(12) << iter->second
+              << setw(12) << result.seconds
+              << fixed
+              << setprecision(1)
+              << setw(8) << showpos << change * 100 << noshowpos << "%";
+
+         if (change > tolerance)
+         {
+            cout << "  REGRESSION!!!";
+            ++regressions;
+         }
+
+         cout << endl;
+      }
+
+      cout << endl;
+
+      if (regressions > 0)
+      {
+         cout << regressions
+              << " benchmark(s) more than "
+              << fixed
+              << setprecision(0)
+              << tolerance * 100
+              << "% slower than "
+              << "the baseline"
+              << endl;
+
+         cout << endl;
+      }
+
+      return regressions;
+   }
+}
@@ -0,0 +1,302 @@
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+#include "candidate_columns.h"
+#include "hash.h"
+#include "parameters.h"
+#include "thread_pool.h"
+
+namespace
+{
+   // Copying every guess's patterns for the candidates costs about as
+   // much as scoring them once, and takes memory, so it is only done
+   // once they are down to this fraction of the answers.
+   constexpr my_uint_t COMPACTION_DIVISOR{4};
+
+   // With a memory budget, the copies made for every game that can be
+   // played at once, one per thread, share this fraction of it
+   constexpr my_uint_t COPIES_BUDGET_DIVISOR{4};
+
+   constexpr my_uint_t GUESSES_PER_TASK{256};
+
+   // Equal rows hash equal
+   uint64_t row_hash(const pattern_t *row, my_uint_t length);
+}
+
+candidate_columns_t::candidate_columns_t(const pattern_matrix_t &pattern_matrix):
+   pattern_matrix{pattern_matrix},
+   candidate_indices(pattern_matrix.num_answers()),
+   is_compacted{false}
+{
+   for (my_uint_t a{0}; a < candidate_indices.size(); ++a)
+      candidate_indices[a] = a;
+}
+
+void candidate_columns_t::compact(const vector<uint32_t> &candidates)
+{
+   if (candidates.size() == candidate_indices.size())
+      return;
+
+   const my_uint_t copy_bytes{pattern_matrix.num_guesses() * candidates.size() * sizeof(pattern_t)};
+
+   if (
+         ! compacted() &&
+         (
+            candidates.size() * COMPACTION_DIVISOR > pattern_matrix.num_answers() ||
+            (
+               parameters.memory_budget > 0 &&
+               copy_bytes > parameters.memory_budget / COPIES_BUDGET_DIVISOR / num_threads()
+            )
+         )
+      )
+   {
+      candidate_indices = candidates;
+      return;
+   }
+
+   // Where each remaining candidate's patterns are in the current rows
+   vector<uint32_t> positions;
+
+   positions.reserve(candidates.size());
+
+   if (! compacted())
+      positions = candidates;
+   else
+   {
+      for (my_uint_t i{0}, j{0}; i < candidates.size(); ++i, ++j)
+      {
+         while (j < candidate_indices.size() && candidate_indices[j] < candidates[i])
+            ++j;
+
+         if (j == candidate_indices.size() || candidate_indices[j] != candidates[i])
+         {
+            stringstream ss;
+
+            ss << "Answer " << candidates[i] << " is not a remaining candidate";
+            throw runtime_error(ss.str());
+         }
+
+         positions.push_back(j);
+      }
+   }
+
+   const my_uint_t num_rows{compacted() ? guess_indices.size() : pattern_matrix.num_guesses()};
+   const my_uint_t row_length{candidates.size()};
+
+   // With no matrix to copy from, the patterns are computed
+   const bool computed{! compacted() && ! pattern_matrix.materialized()};
+   const letter_columns_t candidate_letters{
+                                              computed ?
+                                              pattern_matrix.answer_columns(candidates) :
+                                              letter_columns_t{}
+                                           };
+
+   // Copy every row, noting which ones still split the candidates, and
+   // a hash of each of those
+   vector<pattern_t> compacted_columns(num_rows * row_length);
+   vector<uint8_t> keep(num_rows);
+   vector<uint64_t> hashes(num_rows);
+
+   thread_pool().parallel_for(
+                                0,
+                                num_rows,
+                                GUESSES_PER_TASK,
+                                [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                {
+                                   with_word_length(
+                                                      parameters.word_length,
+                                                      [&]<my_uint_t WORD_LENGTH>()
+                                                      {
+                                                         for (my_uint_t r{first}; r < last; ++r)
+                                                         {
+                                                            pattern_t *const target{compacted_columns.data() + r * row_length};
+
+                                                            if (computed)
+                                                            {
+                                                               pattern_kernel_t<WORD_LENGTH>::compute_patterns(
+                                                                                                                 pattern_matrix.guess_letters(r),
+                                                                                                                 candidate_letters,
+                                                                                                                 0,
+                                                                                                                 row_length,
+                                                                                                                 target
+                                                                                                              );
+                                                            }
+                                                            else
+                                                            {
+                                                               const pattern_t *const source{
+                                                                                               compacted() ?
+                                                                                               row_at(r) :
+                                                                                               pattern_matrix.row(r)
+                                                                                            };
+
+                                                               for (my_uint_t i{0}; i < row_length; ++i)
+                                                                  target[i] = source[positions[i]];
+                                                            }
+
+                                                            keep[r] = any_of(
+                                                                               target,
+                                                                               target + row_length,
+                                                                               [&](pattern_t pattern){ return pattern != target[0]; }
+                                                                            );
+
+                                                            if (keep[r])
+                                                               hashes[r] = row_hash(target, row_length);
+                                                         }
+                                                      }
+                                                   );
+                                }
+                             );
+
+   // Guesses with the same row split every subset of the candidates
+   // the same way from now on, so each class of them keeps only its
+   // first row, which holds its lowest guess. Classes are found with an
+   // open addressing table of their first rows, plus one so that zero
+   // marks an empty slot.
+   const auto row_of{[&](my_uint_t r){ return compacted_columns.data() + r * row_length; }};
+
+   my_uint_t table_size{1};
+
+   while (table_size < 2 * num_rows)
+      table_size *= 2;
+
+   vector<uint32_t> table(table_size, 0);
+   vector<uint32_t> class_row(num_rows);
+   vector<uint32_t> class_size(num_rows, 0);
+
+   for (my_uint_t r{0}; r < num_rows; ++r)
+   {
+      if (! keep[r])
+         continue;
+
+      my_uint_t slot{hashes[r] & (table_size - 1)};
+
+      while (
+               table[slot] != 0 &&
+               ! (
+                    hashes[table[slot] - 1] == hashes[r] &&
+                    equal(row_of(r), row_of(r) + row_length, row_of(table[slot] - 1))
+                 )
+            )
+      {
+         slot = (slot + 1) & (table_size - 1);
+      }
+
+      if (table[slot] == 0)
+         table[slot] = r + 1;
+
+      class_row[r] = table[slot] - 1;
+      class_size[class_row[r]] += compacted() ? members(r).size() : 1;
+   }
+
+   // Lay the classes' guesses out one class after another, in the
+   // order of their first rows
+   vector<uint32_t> kept_member_starts;
+   vector<uint32_t> next_member(num_rows);
+   my_uint_t num_members{0};
+
+   for (my_uint_t r{0}; r < num_rows; ++r)
+   {
+      if (keep[r] && class_row[r] == r)
+      {
+         kept_member_starts.push_back(num_members);
+         next_member[r] = num_members;
+         num_members += class_size[r];
+      }
+   }
+
+   kept_member_starts.push_back(num_members);
+
+   vector<uint32_t> kept_members(num_members);
+
+   for (my_uint_t r{0}; r < num_rows; ++r)
+   {
+      if (! keep[r])
+         continue;
+
+      uint32_t &next{next_member[class_row[r]]};
+
+      if (compacted())
+      {
+         for (uint32_t guess_index : members(r))
+            kept_members[next++] = guess_index;
+      }
+      else
+         kept_members[next++] = r;
+   }
+
+   // Rows taken in order give their guesses in order, but guesses from
+   // several earlier classes may interleave
+   if (compacted())
+   {
+      for (my_uint_t c{0}; c + 1 < kept_member_starts.size(); ++c)
+      {
+         if (kept_member_starts[c + 1] - kept_member_starts[c] > 1)
+         {
+            sort(
+                   kept_members.begin() + kept_member_starts[c],
+                   kept_members.begin() + kept_member_starts[c + 1]
+                );
+         }
+      }
+   }
+
+   // Close up the gaps left by the rows dropped and merged
+   vector<uint32_t> kept_guesses;
+   pattern_t *next_row{compacted_columns.data()};
+
+   for (my_uint_t r{0}; r < num_rows; ++r)
+   {
+      if (! keep[r] || class_row[r] != r)
+         continue;
+
+      kept_guesses.push_back(kept_members[kept_member_starts[kept_guesses.size()]]);
+
+      const pattern_t *const row{row_of(r)};
+
+      if (row != next_row)
+         copy(row, row + row_length, next_row);
+
+      next_row += row_length;
+   }
+
+   compacted_columns.resize(next_row - compacted_columns.data());
+   compacted_columns.shrink_to_fit();
+
+   candidate_indices = candidates;
+   guess_indices = std::move(kept_guesses);
+   member_guesses = std::move(kept_members);
+   member_starts = std::move(kept_member_starts);
+   columns = std::move(compacted_columns);
+   is_compacted = true;
+}
+
+namespace
+{
+   uint64_t row_hash(const pattern_t *row, my_uint_t length)
+   {
+      // Only one multiply per four patterns, and a full mix at the end
+      constexpr uint64_t MULTIPLIER{0x9e3779b97f4a7c15};
+
+      uint64_t hash{length};
+      my_uint_t i{0};
+
+      for (; i + 4 <= length; i += 4)
+      {
+         uint64_t chunk;
+
+         memcpy(&chunk, row + i, sizeof(chunk));
+         hash = (hash ^ chunk) * MULTIPLIER;
+      }
+
+      for (; i < length; ++i)
+         hash = (hash ^ row[i]) * MULTIPLIER;
+
+      return mix64(hash);
+   }
+}
@@ -0,0 +1,70 @@
+#ifndef CANDIDATE_COLUMNS_INCLUDED
+#define CANDIDATE_COLUMNS_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+using namespace std;
+
+#include "pattern_matrix.h"
+#include "type_aliases.h"
+
+// The pattern matrix cut down to a game's remaining candidates. Once
+// few enough candidates remain, their columns are copied out so that
+// each guess's patterns for them are contiguous, and scoring a guess
+// reads only those. Every later round compacts the copy further, so
+// its cost follows the number of candidates rather than the size of
+// the dictionary. Guesses that give every candidate the same result
+// are dropped when compacting, for good: they cannot split any subset
+// of the candidates either. Guesses whose rows come out the same are
+// kept as one class under a single row, since no later subset of the
+// candidates can tell them apart; classes only merge as candidates are
+// cut down. With a memory budget, nothing is copied until the copy
+// fits the game's share of it.
+class candidate_columns_t
+{
+   public:
+      // Every answer a candidate
+      explicit candidate_columns_t(const pattern_matrix_t &pattern_matrix);
+
+      // Cut the candidates down to candidates (ascending answer
+      // indices), which must all be candidates already
+      void compact(const vector<uint32_t> &candidates);
+
+      const vector<uint32_t> &candidates() const { return candidate_indices; }
+
+      // Whether the rows below may be used yet
+      bool compacted() const { return is_compacted; }
+
+      // The lowest guess of each class, ascending, each with a row of
+      // its patterns for every candidate, in the same order
+      const vector<uint32_t> &guesses() const { return guess_indices; }
+
+      // Every guess in the class of row i, ascending
+      span<const uint32_t> members(my_uint_t i) const
+      {
+         return {member_guesses.data() + member_starts[i], member_guesses.data() + member_starts[i + 1]};
+      }
+
+      const pattern_t *row_at(my_uint_t i) const
+      {
+         return columns.data() + i * candidate_indices.size();
+      }
+
+   private:
+      const pattern_matrix_t &pattern_matrix;
+      vector<uint32_t> candidate_indices;
+      bool is_compacted;
+
+      // Empty until compacted
+      vector<uint32_t> guess_indices;
+      vector<pattern_t> columns;
+
+      // The classes' guesses, one class after another, and where each
+      // class starts, with the end of the last one at the end
+      vector<uint32_t> member_guesses;
+      vector<uint32_t> member_starts;
+};
+
+#endif
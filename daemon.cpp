@@ -0,0 +1,702 @@
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "daemon.h"
+#include "game.h"
+#include "parameters.h"
+#include "thread_pool.h"
+
+namespace
+{
+   // Latencies are counted in buckets this many to each doubling, so
+   // percentiles are within about 4%, up to 2^32 microseconds
+   constexpr my_uint_t LATENCY_BUCKETS_PER_DOUBLING{16};
+   constexpr my_uint_t NUM_LATENCY_BUCKETS{32 * LATENCY_BUCKETS_PER_DOUBLING + 1};
+
+   // The latencies of one type of request, in microseconds, in log-scale
+   // buckets so that memory stays the same however many are served
+   class latency_histogram_t
+   {
+      public:
+         void add(double latency);
+
+         // Nearest-rank percentile, as the top of its bucket
+         double percentile(double p) const;
+
+         uint64_t count() const { return num_latencies; }
+         double largest() const { return max_latency; }
+
+      private:
+         array<uint64_t, NUM_LATENCY_BUCKETS> buckets{};
+         uint64_t num_latencies{0};
+         double max_latency{0};
+   };
+
+   // One game being played by a client. Requests for the same session
+   // may arrive on different connections, so the game has a lock.
+   struct session_t
+   {
+      explicit session_t(const solver_context_t &context): no_output{nullptr},
+                                                           game{context, no_output}
+      {
+      }
+
+      mutex game_mutex;
+      ostream no_output;
+      game_t game;
+
+      // When the last request for the session came in. Guarded by the
+      // server's sessions_mutex.
+      chrono::steady_clock::time_point last_used;
+   };
+
+   // One client connection. Only the event loop touches it, except that
+   // the task answering its current request clears busy when done.
+   struct connection_t
+   {
+      explicit connection_t(int fd): fd{fd}, busy{false}, closed{false}, rejected{false}
+      {
+      }
+
+      int fd;
+      string input;
+      atomic<bool> busy;
+      bool closed;
+
+      // Sent a request line that was too long. It has had its error and
+      // the end of the output, and what it sends is thrown away until
+      // it closes, so that the error is not lost to a reset connection.
+      bool rejected;
+   };
+
+   struct server_t
+   {
+      explicit server_t(const solver_context_t &context): context{context},
+                                                          next_session_id{1},
+                                                          stopping{false},
+                                                          running_tasks{0}
+      {
+      }
+
+      const solver_context_t &context;
+
+      mutex sessions_mutex;
+      map<uint64_t, shared_ptr<session_t>> sessions;
+      uint64_t next_session_id;
+
+      // Request type --> latencies of requests of that type, from
+      // being read to being answered
+      mutable mutex latencies_mutex;
+      map<string, latency_histogram_t> latencies;
+
+      // Written to whenever the event loop should wake up
+      int wake_pipe[2];
+
+      atomic<bool> stopping;
+
+      // Requests handed to the thread pool that have not finished with
+      // the server yet
+      mutex tasks_mutex;
+      condition_variable tasks_done;
+      my_uint_t running_tasks;
+   };
+
+   // Lets the signal handler wake the event loop
+   int signal_wake_fd{-1};
+   volatile sig_atomic_t stop_signalled{0};
+
+   void on_stop_signal(int);
+
+   void wake(int fd);
+
+   void dispatch(server_t &server, connection_t &connection);
+
+   // Whether the connection's next request line, complete or not, is
+   // longer than DAEMON_MAX_REQUEST_LENGTH
+   bool request_too_long(const connection_t &connection);
+
+   // A client that has gone away just misses what is sent
+   void send_all(int fd, const string &data);
+
+   string handle_request(
+                           server_t &server,
+                           const string &request,
+                           string &request_type
+                        );
+
+   shared_ptr<session_t> find_session(server_t &server, istringstream &args);
+
+   // Returns true, with "error unexpected <word>" in error, if args
+   // has anything left
+   bool extra_args(istringstream &args, string &error);
+
+   void drop_idle_sessions(server_t &server);
+
+   string latency_summary(const server_t &server);
+   void print_latency_report(const server_t &server);
+}
+
+int run_daemon(const solver_context_t &context, const string &socket_path)
+{
+   server_t server{context};
+
+   sockaddr_un address{};
+
+   address.sun_family = AF_UNIX;
+
+   if (socket_path.size() >= sizeof(address.sun_path))
+   {
+      stringstream ss;
+
+      ss << "Socket path " << socket_path << " is too long";
+      throw runtime_error(ss.str());
+   }
+
+   memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+   const int listen_fd{socket(AF_UNIX, SOCK_STREAM, 0)};
+
+   // A socket file left behind by an earlier run would make bind() fail
+   unlink(socket_path.c_str());
+
+   if (
+         listen_fd < 0 ||
+         bind(listen_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+         listen(listen_fd, SOMAXCONN) != 0 ||
+         pipe(server.wake_pipe) != 0
+      )
+   {
+      stringstream ss;
+
+      ss << "Unable to listen on " << socket_path << ": " << strerror(errno);
+      throw runtime_error(ss.str());
+   }
+
+   for (int fd : server.wake_pipe)
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+   signal_wake_fd = server.wake_pipe[1];
+   signal(SIGINT, on_stop_signal);
+   signal(SIGTERM, on_stop_signal);
+
+   cout << "Serving on " << socket_path << endl;
+
+   map<int, unique_ptr<connection_t>> connections;
+
+   // Idle sessions are looked for this often
+   constexpr int IDLE_CHECK_MILLISECONDS{60 * 1000};
+
+   // Carry on after being asked to stop until every request already
+   // started has been answered
+   while (
+            ! (server.stopping || stop_signalled) ||
+            any_of(
+                     connections.cbegin(),
+                     connections.cend(),
+                     [](const auto &entry){ return entry.second->busy.load(); }
+                  )
+         )
+   {
+      const bool stopping{server.stopping || stop_signalled};
+
+      // Connections that are waiting for an answer are not read from
+      // until they get it, so each connection has one request running
+      // at most.
+      vector<pollfd> poll_fds{{server.wake_pipe[0], POLLIN, 0}};
+
+      if (! stopping)
+         poll_fds.push_back({listen_fd, POLLIN, 0});
+
+      for (const auto &[fd, connection] : connections)
+      {
+         if (! stopping && ! connection->busy && ! connection->closed)
+            poll_fds.push_back({fd, POLLIN, 0});
+      }
+
+      if (poll(poll_fds.data(), poll_fds.size(), IDLE_CHECK_MILLISECONDS) < 0)
+      {
+         if (errno == EINTR)
+            continue;
+
+         stringstream ss;
+
+         ss << "poll() failed: " << strerror(errno);
+         throw runtime_error(ss.str());
+      }
+
+      for (const pollfd &poll_fd : poll_fds)
+      {
+         if (poll_fd.revents == 0)
+            continue;
+
+         if (poll_fd.fd == server.wake_pipe[0])
+         {
+            char drained[64];
+
+            while (read(server.wake_pipe[0], drained, sizeof(drained)) > 0)
+            {
+            }
+         }
+         else if (poll_fd.fd == listen_fd)
+         {
+            const int fd{accept(listen_fd, nullptr, nullptr)};
+
+            if (fd >= 0)
+               connections.emplace(fd, make_unique<connection_t>(fd));
+         }
+         else
+         {
+            connection_t &connection{*connections.at(poll_fd.fd)};
+            char buffer[4096];
+            const ssize_t bytes_read{read(poll_fd.fd, buffer, sizeof(buffer))};
+
+            if (bytes_read <= 0)
+               connection.closed = true;
+            else if (! connection.rejected)
+               connection.input.append(buffer, bytes_read);
+         }
+      }
+
+      drop_idle_sessions(server);
+
+      // Start on the next request of every idle connection, and drop
+      // closed connections once they have nothing left to answer.
+      for (auto iter{connections.begin()}; iter != connections.end(); )
+      {
+         connection_t &connection{*iter->second};
+
+         if (! connection.busy && ! connection.rejected && request_too_long(connection))
+         {
+            send_all(connection.fd, "error request too long\n");
+            shutdown(connection.fd, SHUT_WR);
+            connection.input.clear();
+            connection.rejected = true;
+         }
+
+         if (! connection.busy && ! stopping && connection.input.find('\n') != string::npos)
+            dispatch(server, connection);
+
+         if (! connection.busy && connection.closed)
+         {
+            close(connection.fd);
+            iter = connections.erase(iter);
+         }
+         else
+            ++iter;
+      }
+   }
+
+   // A task that has answered its request may still be waking the event
+   // loop, through the pipe about to be closed
+   {
+      unique_lock<mutex> ul{server.tasks_mutex};
+
+      server.tasks_done.wait(ul, [&server](){ return server.running_tasks == 0; });
+   }
+
+   for (const auto &[fd, connection] : connections)
+      close(fd);
+
+   close(listen_fd);
+   unlink(socket_path.c_str());
+
+   signal(SIGINT, SIG_DFL);
+   signal(SIGTERM, SIG_DFL);
+   signal_wake_fd = -1;
+
+   close(server.wake_pipe[0]);
+   close(server.wake_pipe[1]);
+
+   print_latency_report(server);
+
+   return 0;
+}
+
+namespace
+{
+   void latency_histogram_t::add(double latency)
+   {
+      // Bucket 0 is below 1 microsecond, and bucket b above it up to
+      // 2^(b / LATENCY_BUCKETS_PER_DOUBLING)
+      const double position{latency < 1 ? 0 : log2(latency) * LATENCY_BUCKETS_PER_DOUBLING + 1};
+
+      ++buckets[min(static_cast<my_uint_t>(position), NUM_LATENCY_BUCKETS - 1)];
+      ++num_latencies;
+      max_latency = max(max_latency, latency);
+   }
+
+   double latency_histogram_t::percentile(double p) const
+   {
+      const uint64_t rank(p / 100 * num_latencies + 0.5);
+      uint64_t seen{0};
+
+      for (my_uint_t b{0}; b + 1 < NUM_LATENCY_BUCKETS; ++b)
+      {
+         seen += buckets[b];
+
+         if (seen >= max(rank, uint64_t{1}))
+         {
+            const double top{exp2(static_cast<double>(b) / LATENCY_BUCKETS_PER_DOUBLING)};
+
+            return min(top, max_latency);
+         }
+      }
+
+      return max_latency;
+   }
+
+   void on_stop_signal(int)
+   {
+      stop_signalled = 1;
+      wake(signal_wake_fd);
+   }
+
+   void wake(int fd)
+   {
+      const char byte{0};
+
+      // If the pipe is full, the event loop is due to wake anyway
+      [[maybe_unused]] const ssize_t written{write(fd, &byte, 1)};
+   }
+
+   void dispatch(server_t &server, connection_t &connection)
+   {
+      const my_uint_t end_of_line{connection.input.find('\n')};
+      string request{connection.input.substr(0, end_of_line)};
+
+      connection.input.erase(0, end_of_line + 1);
+
+      if (! request.empty() && request.back() == '\r')
+         request.pop_back();
+
+      connection.busy = true;
+
+      {
+         lock_guard<mutex> lg{server.tasks_mutex};
+         ++server.running_tasks;
+      }
+
+      const auto start_time{chrono::steady_clock::now()};
+
+      thread_pool().submit(
+                             [&server, &connection, request, start_time]()
+                             {
+                                string request_type;
+                                const string response{
+                                                        handle_request(
+                                                                         server,
+                                                                         request,
+                                                                         request_type
+                                                                      ) +
+                                                        "\n"
+                                                     };
+
+                                send_all(connection.fd, response);
+
+                                const chrono::duration<double, micro> elapsed{
+                                                                                chrono::steady_clock::now() -
+                                                                                start_time
+                                                                             };
+
+                                {
+                                   lock_guard<mutex> lg{server.latencies_mutex};
+
+                                   server.latencies[request_type].add(elapsed.count());
+                                }
+
+                                connection.busy = false;
+                                wake(server.wake_pipe[1]);
+
+                                lock_guard<mutex> lg{server.tasks_mutex};
+
+                                if (--server.running_tasks == 0)
+                                   server.tasks_done.notify_all();
+                             }
+                          );
+   }
+
+   string handle_request(
+                           server_t &server,
+                           const string &request,
+                           string &request_type
+                        )
+   {
+      istringstream args{request};
+
+      if (! (args >> request_type))
+      {
+         request_type = "empty";
+         return "error empty request";
+      }
+
+      string error;
+
+      try
+      {
+         if (request_type == "new")
+         {
+            if (extra_args(args, error))
+               return error;
+
+            auto session{make_shared<session_t>(server.context)};
+            lock_guard<mutex> lg{server.sessions_mutex};
+            const uint64_t id{server.next_session_id++};
+
+            session->last_used = chrono::steady_clock::now();
+            server.sessions.emplace(id, session);
+
+            return "ok " + to_string(id);
+         }
+         else if (request_type == "guess")
+         {
+            const shared_ptr<session_t> session{find_session(server, args)};
+
+            if (extra_args(args, error))
+               return error;
+
+            lock_guard<mutex> lg{session->game_mutex};
+
+            if (session->game.solved() || session->game.failed())
+               return "error game over";
+
+            return "guess " + session->game.next_guess();
+         }
+         else if (request_type == "submit")
+         {
+            const shared_ptr<session_t> session{find_session(server, args)};
+            string guess;
+            string result;
+
+            if (! (args >> guess >> result))
+               return "error usage: submit <session> <word> <result>";
+
+            if (extra_args(args, error))
+               return error;
+
+            // Throws if the guess is not an allowed word
+            server.context.pattern_matrix.guess_index(guess);
+
+            if (
+                  result.size() != parameters.word_length ||
+                  result.find_first_not_of("byg") != string::npos
+               )
+            {
+               return "error invalid result " + result;
+            }
+
+            lock_guard<mutex> lg{session->game_mutex};
+            game_t &game{session->game};
+
+            if (game.solved() || game.failed())
+               return "error game over";
+
+            game.submit(guess, result);
+
+            if (game.solved())
+               return "solved " + to_string(game.round());
+
+            if (game.failed())
+               return "failed";
+
+            return "ok " + to_string(game.possible_answers().size());
+         }
+         else if (request_type == "end")
+         {
+            const shared_ptr<session_t> session{find_session(server, args)};
+
+            if (extra_args(args, error))
+               return error;
+
+            lock_guard<mutex> lg{server.sessions_mutex};
+
+            erase_if(
+                       server.sessions,
+                       [&session](const auto &entry){ return entry.second == session; }
+                    );
+
+            return "ok";
+         }
+         else if (request_type == "stats")
+         {
+            if (extra_args(args, error))
+               return error;
+
+            return latency_summary(server);
+         }
+         else if (request_type == "shutdown")
+         {
+            if (extra_args(args, error))
+               return error;
+
+            server.stopping = true;
+
+            return "ok";
+         }
+
+         const string unknown{request_type};
+
+         request_type = "unknown";
+
+         return "error unknown request " + unknown;
+      }
+      catch (const exception &e)
+      {
+         return string{"error "} + e.what();
+      }
+   }
+
+   shared_ptr<session_t> find_session(server_t &server, istringstream &args)
+   {
+      uint64_t id;
+
+      if (! (args >> id))
+         throw runtime_error("missing session");
+
+      lock_guard<mutex> lg{server.sessions_mutex};
+
+      const auto iter{server.sessions.find(id)};
+
+      if (iter == server.sessions.cend())
+         throw runtime_error("unknown session " + to_string(id));
+
+      iter->second->last_used = chrono::steady_clock::now();
+
+      return iter->second;
+   }
+
+   bool request_too_long(const connection_t &connection)
+   {
+      const my_uint_t end_of_line{connection.input.find('\n')};
+
+      return end_of_line == string::npos ?
+             connection.input.size() > DAEMON_MAX_REQUEST_LENGTH :
+             end_of_line > DAEMON_MAX_REQUEST_LENGTH;
+   }
+
+   void send_all(int fd, const string &data)
+   {
+      for (my_uint_t sent{0}; sent < data.size(); )
+      {
+         const ssize_t n{send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL)};
+
+         if (n <= 0)
+            break;
+
+         sent += n;
+      }
+   }
+
+   bool extra_args(istringstream &args, string &error)
+   {
+      string extra;
+
+      if (! (args >> extra))
+         return false;
+
+      error = "error unexpected " + extra;
+
+      return true;
+   }
+
+   void drop_idle_sessions(server_t &server)
+   {
+      const auto oldest{chrono::steady_clock::now() - chrono::seconds{DAEMON_SESSION_IDLE_SECONDS}};
+      lock_guard<mutex> lg{server.sessions_mutex};
+
+      // A request still running keeps its session alive until it is
+      // answered
+      erase_if(
+                 server.sessions,
+                 [&oldest](const auto &entry){ return entry.second->last_used < oldest; }
+              );
+   }
+
+   string latency_summary(const server_t &server)
+   {
+      lock_guard<mutex> lg{server.latencies_mutex};
+      stringstream ss;
+
+      ss << "stats" << fixed << setprecision(1);
+
+      for (const auto &[request_type, latencies] : server.latencies)
+      {
+         ss << " "
+            << request_type
+            << " "
+            << latencies.count()
+            << " "
+            << latencies.percentile(50)
+            << " "
+            << latencies.percentile(90)
+            << " "
+            << latencies.percentile(99)
+            << " "
+            << latencies.largest();
+      }
+
+      return ss.str();
+   }
+
+   void print_latency_report(const server_t &server)
+   {
+      istringstream summary{latency_summary(server)};
+      string word;
+
+      summary >> word;
+
+      cout << "Request latencies in microseconds:" << endl;
+
+      cout << setw(10) << "Request"
+           << setw(10) << "Count"
+           << setw(10) << "p50"
+           << setw(10) << "p90"
+           << setw(10) << "p99"
+           << setw(10) << "Max"
+           << endl;
+
+      string request_type;
+      string count;
+      string p50;
+      string p90;
+      string p99;
+      string max;
+
+      while (summary >> request_type >> count >> p50 >> p90 >> p99 >> max)
+      {
+         cout << setw(10) << request_type
+              << setw(10) << count
+              << setw(10) << p50
+              << setw(10) << p90
+              << setw(10) << p99
+              << setw(10) << max
+              << endl;
+      }
+
+      cout << endl;
+   }
+}
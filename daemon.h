@@ -0,0 +1,35 @@
+#ifndef DAEMON_INCLUDED
+#define DAEMON_INCLUDED
+
+#include <string>
+
+using namespace std;
+
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// Serve game sessions over a Unix domain socket at socket_path until a
+// client sends "shutdown" or the process gets SIGINT or SIGTERM. The
+// word lists and tables in the context are loaded once and shared by
+// every session. The protocol is one request per line, each answered by
+// one line:
+//
+//    new                            ok <session>
+//    guess <session>                guess <word>
+//    submit <session> <word> <result>
+//                                   ok <answers left> | solved <rounds>
+//                                   | failed
+//    end <session>                  ok
+//    stats                          stats <request> <count> <p50> <p90>
+//                                   <p99> <max> ... (microseconds,
+//                                   percentiles to within about 4%)
+//    shutdown                       ok
+//
+// Malformed requests get "error <reason>". Any client may use any
+// session. A session with no requests for DAEMON_SESSION_IDLE_SECONDS
+// is ended as if by "end". Requests are run as thread pool tasks, so many sessions are
+// served at once; requests on one connection are answered in order.
+// Returns the process exit status.
+int run_daemon(const solver_context_t &context, const string &socket_path);
+
+#endif
@@ -0,0 +1,575 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "decision_tree.h"
+#include "game.h"
+#include "parameters.h"
+#include "thread_pool.h"
+#include "tools.h"
+
+namespace
+{
+   // Bump this whenever the layout of the tree file changes.
+   constexpr uint32_t TREE_VERSION{1};
+
+   constexpr char TREE_MAGIC[8]{'W', 'S', 'D', 'T', 'R', 'E', 'E', '\0'};
+
+   // The file is this header, then num_words words of word_length
+   // characters (padded to a multiple of four bytes), then the nodes
+   // as num_node_words 32-bit words. Each node is its guess's index
+   // in the word table and its number of children, followed by that
+   // many (pattern, child node offset) pairs in increasing pattern
+   // order. Node offsets count 32-bit words from the first node.
+   struct tree_header_t
+   {
+      char magic[8];
+      uint32_t version;
+      uint32_t word_length;
+      uint64_t dictionary_hash;
+      uint64_t num_words;
+      uint64_t num_node_words;
+   };
+
+   struct tree_node_t
+   {
+      uint32_t guess_index;
+      bool guess_may_be_answer;
+
+      // Remaining answers whose games would run out of rounds below
+      // this node; their results get no child node.
+      my_uint_t failed_answers;
+
+      vector<pair<pattern_t, unique_ptr<tree_node_t>>> children;
+   };
+
+   struct tree_stats_t
+   {
+      my_uint_t num_nodes{0};
+      my_uint_t total_rounds{0};
+      my_uint_t num_solved{0};
+      my_uint_t num_failed{0};
+   };
+
+   unique_ptr<tree_node_t> expand(
+                                    const pattern_matrix_t &pattern_matrix,
+                                    game_t &game
+                                 );
+
+   void serialize(
+                    const tree_node_t &node,
+                    map<uint32_t, uint32_t> &word_table_index,
+                    vector<uint32_t> &node_words
+                 );
+
+   void collect_stats(const tree_node_t &node, my_uint_t depth, tree_stats_t &stats);
+
+   // Whether the nodes run back to back to the end, each guessing a
+   // word in the word table, with its patterns in increasing order and
+   // each child's offset that of a later node. Guarantees that walking
+   // the tree never reads outside the nodes or the word table.
+   bool valid_nodes(
+                      const uint32_t *nodes,
+                      uint64_t num_node_words,
+                      uint64_t num_words,
+                      my_uint_t word_length
+                   );
+}
+
+void build_decision_tree(
+                           const solver_context_t &context,
+                           const string &filename
+                        )
+{
+   const pattern_matrix_t &pattern_matrix{context.pattern_matrix};
+   const auto start_time{chrono::steady_clock::now()};
+
+   ostream no_output{nullptr};
+   game_t root_game{context, no_output};
+
+   const unique_ptr<tree_node_t> root{expand(pattern_matrix, root_game)};
+
+   // Every guess word used anywhere in the tree goes into the word
+   // table once, in the order the words are first used.
+   map<uint32_t, uint32_t> word_table_index;
+   vector<uint32_t> node_words;
+
+   serialize(*root, word_table_index, node_words);
+
+   tree_header_t header{};
+
+   memcpy(header.magic, TREE_MAGIC, sizeof(TREE_MAGIC));
+   header.version = TREE_VERSION;
+   header.word_length = parameters.word_length;
+   header.dictionary_hash = pattern_matrix.dictionary_hash();
+   header.num_words = word_table_index.size();
+   header.num_node_words = node_words.size();
+
+   string word_table(word_table_index.size() * parameters.word_length, '\0');
+
+   for (const auto &[guess_index, table_index] : word_table_index)
+   {
+      memcpy(
+               &word_table[table_index * parameters.word_length],
+               pattern_matrix.guess_word(guess_index).data(),
+               parameters.word_length
+            );
+   }
+
+   word_table.resize((word_table.size() + 3) / 4 * 4, '\0');
+
+   ofstream tree_file{filename, ios::binary};
+
+   tree_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+   tree_file.write(word_table.data(), word_table.size());
+
+   tree_file.write(
+                    reinterpret_cast<const char *>(node_words.data()),
+                    node_words.size() * sizeof(uint32_t)
+                 );
+
+   tree_file.close();
+
+   if (! tree_file)
+   {
+      stringstream ss;
+
+      ss << "Unable to write " << filename;
+      throw runtime_error(ss.str());
+   }
+
+   const chrono::duration<double> elapsed{chrono::steady_clock::now() - start_time};
+
+   tree_stats_t stats;
+
+   collect_stats(*root, 1, stats);
+
+   cout << "Decision tree written to " << filename << endl;
+   cout << "Nodes: " << stats.num_nodes << endl;
+   cout << "Distinct guess words: " << word_table_index.size() << endl;
+   cout << "Answers solved: " << stats.num_solved << endl;
+   cout << "Answers not solved: " << stats.num_failed << endl;
+
+   if (stats.num_solved > 0)
+   {
+      cout << "Average rounds: "
+           << fixed
+           << setprecision(6)
+           << stats.total_rounds / static_cast<double>(stats.num_solved)
+           << endl;
+   }
+
+   if (context.guess_cache != nullptr)
+      context.guess_cache->print_stats(cout);
+
+   cout << "Elapsed time: "
+        << fixed
+        << setprecision(2)
+        << elapsed.count()
+        << " s"
+        << endl;
+
+   cout << endl;
+}
+
+decision_tree_t::decision_tree_t(const string &filename): words{nullptr},
+                                                          nodes{nullptr},
+                                                          num_words{0},
+                                                          num_node_words{0},
+                                                          tree_word_length{0},
+                                                          mapping{nullptr},
+                                                          mapping_size{0}
+{
+   const int fd{open(filename.c_str(), O_RDONLY)};
+
+   if (fd < 0)
+   {
+      stringstream ss;
+
+      ss << filename << " is missing";
+      throw runtime_error(ss.str());
+   }
+
+   struct stat st{};
+
+   if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(tree_header_t))
+   {
+      close(fd);
+
+      stringstream ss;
+
+      ss << filename << " is not a decision tree file";
+      throw runtime_error(ss.str());
+   }
+
+   void *p{mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0)};
+
+   close(fd);
+
+   if (p == MAP_FAILED)
+   {
+      stringstream ss;
+
+      ss << "Unable to map " << filename;
+      throw runtime_error(ss.str());
+   }
+
+   mapping = p;
+   mapping_size = st.st_size;
+
+   tree_header_t header;
+
+   memcpy(&header, p, sizeof(header));
+
+   // Both counts are bounded by the file size first, so that the sizes
+   // worked out from them cannot overflow
+   const bool compatible{
+                           memcmp(header.magic, TREE_MAGIC, sizeof(TREE_MAGIC)) == 0 &&
+                           header.version == TREE_VERSION &&
+                           header.word_length >= MIN_WORD_LENGTH &&
+                           header.word_length <= MAX_WORD_LENGTH &&
+                           header.num_words <= mapping_size / header.word_length &&
+                           header.num_node_words <= mapping_size / sizeof(uint32_t)
+                        };
+
+   const size_t word_table_size{compatible ? (header.num_words * header.word_length + 3) / 4 * 4 : 0};
+
+   if (
+         ! compatible ||
+         mapping_size != sizeof(header) +
+                         word_table_size +
+                         header.num_node_words * sizeof(uint32_t)
+      )
+   {
+      munmap(mapping, mapping_size);
+
+      stringstream ss;
+
+      ss << filename << " is not a compatible decision tree file";
+      throw runtime_error(ss.str());
+   }
+
+   words = static_cast<const char *>(p) + sizeof(header);
+   nodes = reinterpret_cast<const uint32_t *>(words + word_table_size);
+
+   if (! valid_nodes(nodes, header.num_node_words, header.num_words, header.word_length))
+   {
+      munmap(mapping, mapping_size);
+
+      stringstream ss;
+
+      ss << filename << " is a corrupt decision tree file";
+      throw runtime_error(ss.str());
+   }
+
+   num_words = header.num_words;
+   num_node_words = header.num_node_words;
+   tree_word_length = header.word_length;
+}
+
+decision_tree_t::~decision_tree_t()
+{
+   munmap(mapping, mapping_size);
+}
+
+string decision_tree_t::guess(uint32_t node) const
+{
+   return string(words + nodes[node] * tree_word_length, tree_word_length);
+}
+
+uint32_t decision_tree_t::child(uint32_t node, pattern_t pattern) const
+{
+   const uint32_t num_children{nodes[node + 1]};
+   const uint32_t *first{nodes + node + 2};
+
+   // Binary search over the (pattern, offset) pairs
+   my_uint_t low{0};
+   my_uint_t high{num_children};
+
+   while (low < high)
+   {
+      const my_uint_t middle{(low + high) / 2};
+
+      if (first[2 * middle] < pattern)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+
+   if (low < num_children && first[2 * low] == pattern)
+      return first[2 * low + 1];
+
+   return NO_NODE;
+}
+
+my_uint_t play_decision_tree(const string &filename, const string &target_word)
+{
+   const decision_tree_t tree{filename};
+
+   // No word lists are loaded, so take the word length from the tree
+   parameters.set_word_length(tree.word_length());
+
+   if (target_word != "" && target_word.size() != parameters.word_length)
+   {
+      cout << "The supplied target word, "
+           << target_word
+           << ", does not have "
+           << parameters.word_length
+           << " letters!"
+           << endl;
+
+      cout << endl;
+
+      return parameters.rounds + 1;
+   }
+
+   stringstream result_ss;
+   result_ss << "[byg]{" << parameters.word_length << "}";
+   const regex result_regex(result_ss.str());
+
+   const string all_green(parameters.word_length, 'g');
+   uint32_t node{decision_tree_t::ROOT};
+
+   for (my_uint_t round{1}; round <= parameters.rounds; ++round)
+   {
+      cout << "Round " << round << endl;
+
+      const string guess{tree.guess(node)};
+
+      cout << "Guess from decision tree: " << guess << endl;
+
+      string result;
+
+      if (target_word != "")
+      {
+         result = decode_pattern(compute_pattern(target_word, guess));
+         cout << result << endl;
+      }
+      else
+         get_user_input("Result", result_regex, result);
+
+      if (result == all_green)
+         return round;
+
+      node = tree.child(node, encode_result(result));
+
+      if (node == decision_tree_t::NO_NODE)
+      {
+         cout << "No allowed answer word gives that result!" << endl;
+         break;
+      }
+
+      cout << endl;
+   }
+
+   cout << "Could not solve the puzzle!" << endl;
+   cout << endl;
+
+   return parameters.rounds + 1;
+}
+
+namespace
+{
+   unique_ptr<tree_node_t> expand(
+                                    const pattern_matrix_t &pattern_matrix,
+                                    game_t &game
+                                 )
+   {
+      auto node{make_unique<tree_node_t>()};
+
+      const string guess{game.next_guess()};
+
+      node->guess_index = pattern_matrix.guess_index(guess);
+      node->guess_may_be_answer = game.possible_answers().contains(guess);
+      node->failed_answers = 0;
+
+      // Every result the guess can get from a remaining answer, other
+      // than the one that ends the game
+      const pattern_t all_green(parameters.num_patterns - 1);
+      vector<my_uint_t> answers_per_pattern(parameters.num_patterns, 0);
+
+      game.possible_answers().for_each(
+                                         [&](my_uint_t answer_index)
+                                         {
+                                            const pattern_t pattern{
+                                                                      pattern_matrix.pattern(
+                                                                                               node->guess_index,
+                                                                                               answer_index
+                                                                                            )
+                                                                   };
+
+                                            ++answers_per_pattern[pattern];
+                                         }
+                                      );
+
+      for (my_uint_t pattern{0}; pattern < all_green; ++pattern)
+      {
+         if (answers_per_pattern[pattern] > 0)
+            node->children.emplace_back(pattern, nullptr);
+      }
+
+      // Expand the children in parallel. Games that run out of rounds
+      // get no child node.
+      vector<my_uint_t> failed_answers_per_child(node->children.size(), 0);
+
+      thread_pool().parallel_for(
+                                   0,
+                                   node->children.size(),
+                                   1,
+                                   [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                   {
+                                      for (my_uint_t i{first}; i < last; ++i)
+                                      {
+                                         game_t child_game{game};
+
+                                         child_game.submit(
+                                                             guess,
+                                                             decode_pattern(node->children[i].first)
+                                                          );
+
+                                         if (child_game.failed())
+                                         {
+                                            const pattern_t pattern{node->children[i].first};
+
+                                            failed_answers_per_child[i] = answers_per_pattern[pattern];
+                                         }
+                                         else
+                                         {
+                                            node->children[i].second = expand(
+                                                                                pattern_matrix,
+                                                                                child_game
+                                                                             );
+                                         }
+                                      }
+                                   }
+                                );
+
+      for (my_uint_t failed_answers : failed_answers_per_child)
+         node->failed_answers += failed_answers;
+
+      erase_if(
+                 node->children,
+                 [](const auto &child){ return child.second == nullptr; }
+              );
+
+      return node;
+   }
+
+   void serialize(
+                    const tree_node_t &node,
+                    map<uint32_t, uint32_t> &word_table_index,
+                    vector<uint32_t> &node_words
+                 )
+   {
+      const auto [iter, inserted]{
+                                    word_table_index.insert(
+                                                              {
+                                                                 node.guess_index,
+                                                                 word_table_index.size()
+                                                              }
+                                                           )
+                                 };
+
+      const my_uint_t offset{node_words.size()};
+
+      node_words.push_back(iter->second);
+      node_words.push_back(node.children.size());
+
+      for (const auto &[pattern, child] : node.children)
+      {
+         node_words.push_back(pattern);
+         node_words.push_back(0);
+      }
+
+      for (my_uint_t i{0}; i < node.children.size(); ++i)
+      {
+         node_words[offset + 2 + 2 * i + 1] = node_words.size();
+         serialize(*node.children[i].second, word_table_index, node_words);
+      }
+   }
+
+   void collect_stats(const tree_node_t &node, my_uint_t depth, tree_stats_t &stats)
+   {
+      ++stats.num_nodes;
+      stats.num_failed += node.failed_answers;
+
+      // An answer is solved at the node that guesses it
+      if (node.guess_may_be_answer)
+      {
+         ++stats.num_solved;
+         stats.total_rounds += depth;
+      }
+
+      for (const auto &[pattern, child] : node.children)
+         collect_stats(*child, depth + 1, stats);
+   }
+
+   bool valid_nodes(
+                      const uint32_t *nodes,
+                      uint64_t num_node_words,
+                      uint64_t num_words,
+                      my_uint_t word_length
+                   )
+   {
+      // There must be a root
+      if (num_node_words == 0)
+         return false;
+
+      const my_uint_t num_patterns{num_patterns_for(word_length)};
+
+      // Offsets that start a node, found on the first pass and checked
+      // against every child offset on the second
+      vector<bool> node_starts(num_node_words, false);
+
+      for (uint64_t node{0}; node < num_node_words; node += 2 + 2 * nodes[node + 1])
+      {
+         if (
+               num_node_words - node < 2 ||
+               nodes[node] >= num_words ||
+               nodes[node + 1] > (num_node_words - node - 2) / 2
+            )
+            return false;
+
+         node_starts[node] = true;
+
+         for (uint32_t i{0}; i < nodes[node + 1]; ++i)
+         {
+            const uint32_t pattern{nodes[node + 2 + 2 * i]};
+
+            if (pattern >= num_patterns || (i > 0 && pattern <= nodes[node + 2 * i]))
+               return false;
+         }
+      }
+
+      for (uint64_t node{0}; node < num_node_words; node += 2 + 2 * nodes[node + 1])
+      {
+         for (uint32_t i{0}; i < nodes[node + 1]; ++i)
+         {
+            const uint32_t child{nodes[node + 2 + 2 * i + 1]};
+
+            if (child <= node || child >= num_node_words || ! node_starts[child])
+               return false;
+         }
+      }
+
+      return true;
+   }
+}
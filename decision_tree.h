@@ -0,0 +1,64 @@
+#ifndef DECISION_TREE_INCLUDED
+#define DECISION_TREE_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+#include "pattern_matrix.h"
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// The solver is deterministic, so every game it plays follows a path
+// through one fixed tree: each node holds the guess to make and has a
+// child for every result that guess can get. A built tree is saved as
+// a single binary file holding the guess words and the nodes.
+
+// Expand the whole tree from the first round, in parallel, and save it
+// to filename.
+void build_decision_tree(
+                           const solver_context_t &context,
+                           const string &filename
+                        );
+
+// A saved tree, memory-mapped for reading
+class decision_tree_t
+{
+   public:
+      explicit decision_tree_t(const string &filename);
+      ~decision_tree_t();
+
+      decision_tree_t(const decision_tree_t &) = delete;
+      decision_tree_t &operator=(const decision_tree_t &) = delete;
+
+      // Nodes are identified by their offset; the root's is 0.
+      static constexpr uint32_t ROOT{0};
+      static constexpr uint32_t NO_NODE{UINT32_MAX};
+
+      // The length of every word in the tree
+      my_uint_t word_length() const { return tree_word_length; }
+
+      string guess(uint32_t node) const;
+
+      // The node to use after the node's guess got pattern, or NO_NODE
+      // if no remaining answer can give that result.
+      uint32_t child(uint32_t node, pattern_t pattern) const;
+
+   private:
+      const char *words;
+      const uint32_t *nodes;
+      uint64_t num_words;
+      uint64_t num_node_words;
+      my_uint_t tree_word_length;
+
+      void *mapping;
+      size_t mapping_size;
+};
+
+// Play one game by walking the tree saved in filename, prompting for
+// results or computing them against target_word if it is not empty.
+// Returns the number of rounds taken, or parameters.rounds + 1 on failure.
+my_uint_t play_decision_tree(const string &filename, const string &target_word);
+
+#endif
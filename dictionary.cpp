@@ -0,0 +1,653 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "dictionary.h"
+#include "hash.h"
+#include "parameters.h"
+
+namespace
+{
+   // Bump this whenever the layout of the image changes.
+   constexpr uint32_t IMAGE_VERSION{2};
+
+   constexpr char IMAGE_MAGIC[8]{'W', 'S', 'D', 'I', 'C', 'T', 'I', 'M'};
+
+   // Followed by the guess codes, the answers' guess IDs and then the
+   // names of the two source word lists, each ending in '\0'
+   struct image_header_t
+   {
+      char magic[8];
+      uint32_t version;
+      uint32_t word_length;
+      uint64_t num_guesses;
+      uint64_t num_answers;
+      uint64_t names_size;
+      uint64_t dictionary_hash;
+
+      // See image_checksum()
+      uint64_t checksum;
+   };
+
+   // Of the word length, the dictionary hash and everything after the
+   // header
+   uint64_t image_checksum(
+                             my_uint_t word_length,
+                             uint64_t dictionary_hash,
+                             const uint64_t *guess_codes,
+                             my_uint_t num_guesses,
+                             const uint32_t *answer_guess_ids,
+                             my_uint_t num_answers,
+                             const char *names,
+                             my_uint_t names_size
+                          );
+
+   // The size of the image header describes, false if it does not fit
+   // in 64 bits
+   bool image_size(const image_header_t &header, uint64_t &size);
+
+   // Sort and remove duplicates
+   void sort_words(vector<string> &words);
+
+   // 64-bit FNV-1a over the word length and both word lists
+   uint64_t hash_word_lists(
+                              my_uint_t word_length,
+                              const vector<string> &guesses,
+                              const vector<string> &answers
+                           );
+}
+
+dictionary_t::dictionary_t(): length{0},
+                              word_lists_hash{0},
+                              guess_codes{nullptr},
+                              answer_guess_ids{nullptr},
+                              guess_count{0},
+                              answer_count{0},
+                              mapping{nullptr},
+                              mapping_size{0}
+{
+}
+
+dictionary_t::~dictionary_t()
+{
+   unmap();
+}
+
+void dictionary_t::assign(vector<string> guesses, vector<string> answers)
+{
+   guesses.insert(guesses.end(), answers.cbegin(), answers.cend());
+
+   sort_words(guesses);
+   sort_words(answers);
+
+   unmap();
+
+   length = answers.empty() ? 0 : answers.front().size();
+
+   if (length * BITS_PER_LETTER > 64)
+   {
+      stringstream ss;
+
+      ss << "Words of " << length << " letters are too long";
+      throw runtime_error(ss.str());
+   }
+
+   owned_guess_codes.clear();
+   owned_answer_guess_ids.clear();
+
+   owned_guess_codes.reserve(guesses.size());
+   owned_answer_guess_ids.reserve(answers.size());
+
+   for (const string &word : guesses)
+      owned_guess_codes.push_back(encode(word));
+
+   guess_codes = owned_guess_codes.data();
+   guess_count = owned_guess_codes.size();
+
+   for (const string &word : answers)
+      owned_answer_guess_ids.push_back(guess_id(word));
+
+   answer_guess_ids = owned_answer_guess_ids.data();
+   answer_count = owned_answer_guess_ids.size();
+
+   word_lists_hash = hash_word_lists(length, guesses, answers);
+}
+
+void dictionary_t::save_image(
+                                const string &filename,
+                                const string &guesses_source,
+                                const string &answers_source
+                             ) const
+{
+   const string names{guesses_source + '\0' + answers_source + '\0'};
+
+   image_header_t header{};
+
+   memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+   header.version = IMAGE_VERSION;
+   header.word_length = length;
+   header.num_guesses = guess_count;
+   header.num_answers = answer_count;
+   header.names_size = names.size();
+   header.dictionary_hash = word_lists_hash;
+   header.checksum = image_checksum(
+                                      length,
+                                      word_lists_hash,
+                                      guess_codes,
+                                      guess_count,
+                                      answer_guess_ids,
+                                      answer_count,
+                                      names.data(),
+                                      names.size()
+                                   );
+
+   // Write to a temporary file first so that nothing ever maps a
+   // partial image
+   const string temp_filename{temp_filename_for(filename)};
+   ofstream image_file{temp_filename, ios::binary};
+
+   image_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+   image_file.write(
+                      reinterpret_cast<const char *>(guess_codes),
+                      guess_count * sizeof(uint64_t)
+                   );
+
+   image_file.write(
+                      reinterpret_cast<const char *>(answer_guess_ids),
+                      answer_count * sizeof(uint32_t)
+                   );
+
+   image_file.write(names.data(), names.size());
+
+   image_file.close();
+
+   if (! image_file || rename(temp_filename.c_str(), filename.c_str()) != 0)
+   {
+      remove(temp_filename.c_str());
+
+      stringstream ss;
+
+      ss << "Unable to write " << filename;
+      throw runtime_error(ss.str());
+   }
+}
+
+void dictionary_t::load_image(
+                                const string &filename,
+                                string &guesses_source,
+                                string &answers_source
+                             )
+{
+   auto invalid{
+                  [&filename](const string &reason)
+                  {
+                     stringstream ss;
+
+                     ss << filename << " is not a valid dictionary image: " << reason;
+
+                     return runtime_error(ss.str());
+                  }
+               };
+
+   const int fd{open(filename.c_str(), O_RDONLY)};
+
+   if (fd < 0)
+   {
+      stringstream ss;
+
+      ss << filename << " is missing";
+      throw runtime_error(ss.str());
+   }
+
+   struct stat st{};
+
+   if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(image_header_t))
+   {
+      close(fd);
+      throw invalid("too short");
+   }
+
+   const size_t file_size(st.st_size);
+   void *p{mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0)};
+
+   close(fd);
+
+   if (p == MAP_FAILED)
+   {
+      stringstream ss;
+
+      ss << "Unable to map " << filename;
+      throw runtime_error(ss.str());
+   }
+
+   unmap();
+
+   mapping = p;
+   mapping_size = file_size;
+
+   image_header_t header;
+
+   memcpy(&header, p, sizeof(header));
+
+   if (memcmp(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0)
+      throw invalid("wrong magic number");
+
+   if (header.version != IMAGE_VERSION)
+      throw invalid("wrong version");
+
+   if (
+         header.word_length < MIN_WORD_LENGTH ||
+         header.word_length > MAX_WORD_LENGTH ||
+         header.word_length * BITS_PER_LETTER > 64
+      )
+      throw invalid("wrong word length");
+
+   uint64_t expected_size;
+
+   if (
+         header.num_answers > header.num_guesses ||
+         ! image_size(header, expected_size) ||
+         file_size != expected_size
+      )
+      throw invalid("wrong size");
+
+   const char *const data{static_cast<const char *>(p)};
+   const uint64_t *const codes{reinterpret_cast<const uint64_t *>(data + sizeof(header))};
+   const uint32_t *const ids{reinterpret_cast<const uint32_t *>(codes + header.num_guesses)};
+   const char *const names{reinterpret_cast<const char *>(ids + header.num_answers)};
+
+   if (
+         image_checksum(
+                          header.word_length,
+                          header.dictionary_hash,
+                          codes,
+                          header.num_guesses,
+                          ids,
+                          header.num_answers,
+                          names,
+                          header.names_size
+                       ) != header.checksum
+      )
+      throw invalid("wrong checksum");
+
+   // Lookups rely on both lists being sorted without duplicates, and
+   // decoding on every letter being a to z. A letter of 26 (11010) or
+   // more has its top two bits set and one of the next two, which is
+   // tested for every letter at once at the lowest bit of each.
+   static_assert(BITS_PER_LETTER == 5, "the letter check assumes 5-bit letters");
+
+   uint64_t lowest_bits{0};
+
+   for (my_uint_t i{0}; i < header.word_length; ++i)
+      lowest_bits |= uint64_t{1} << (BITS_PER_LETTER * i);
+
+   for (my_uint_t g{0}; g < header.num_guesses; ++g)
+   {
+      const uint64_t code{codes[g]};
+
+      if (g > 0 && codes[g - 1] >= code)
+         throw invalid("guesses out of order");
+
+      if ((code >> 4) & (code >> 3) & ((code >> 2) | (code >> 1)) & lowest_bits)
+         throw invalid("bad letter code");
+   }
+
+   // The codes increase, so only the last can have bits set above its
+   // letters
+   if (header.num_guesses > 0 && codes[header.num_guesses - 1] >> (BITS_PER_LETTER * header.word_length) != 0)
+      throw invalid("bad letter code");
+
+   for (my_uint_t a{0}; a < header.num_answers; ++a)
+   {
+      if (ids[a] >= header.num_guesses || (a > 0 && ids[a - 1] >= ids[a]))
+         throw invalid("answers out of order");
+   }
+
+   const char *const names_end{names + header.names_size};
+   const char *const guesses_source_end{find(names, names_end, '\0')};
+
+   if (
+         guesses_source_end == names_end ||
+         find(guesses_source_end + 1, names_end, '\0') != names_end - 1
+      )
+      throw invalid("bad word list names");
+
+   guesses_source.assign(names, guesses_source_end);
+   answers_source.assign(guesses_source_end + 1, names_end - 1);
+
+   length = header.word_length;
+   word_lists_hash = header.dictionary_hash;
+   guess_codes = codes;
+   guess_count = header.num_guesses;
+   answer_guess_ids = ids;
+   answer_count = header.num_answers;
+
+   owned_guess_codes.clear();
+   owned_answer_guess_ids.clear();
+}
+
+my_uint_t dictionary_t::guess_id(const string &word) const
+{
+   my_uint_t id;
+
+   if (! find_guess(word, id))
+      throw runtime_error(word + " is not an allowed guess word");
+
+   return id;
+}
+
+my_uint_t dictionary_t::answer_id(const string &word) const
+{
+   my_uint_t id;
+
+   if (! find_answer(word, id))
+      throw runtime_error(word + " is not an allowed answer word");
+
+   return id;
+}
+
+bool dictionary_t::find_guess(const string &word, my_uint_t &guess_id) const
+{
+   if (
+         word.size() != length ||
+         ! all_of(word.cbegin(), word.cend(), [](char c){ return c >= 'a' && c <= 'z'; })
+      )
+      return false;
+
+   const uint64_t code{encode(word)};
+   const uint64_t *const end{guess_codes + guess_count};
+   const uint64_t *const iter{lower_bound(guess_codes, end, code)};
+
+   if (iter == end || *iter != code)
+      return false;
+
+   guess_id = iter - guess_codes;
+
+   return true;
+}
+
+bool dictionary_t::find_answer(const string &word, my_uint_t &answer_id) const
+{
+   my_uint_t id;
+
+   return find_guess(word, id) && guess_to_answer(id, answer_id);
+}
+
+bool dictionary_t::guess_to_answer(my_uint_t guess_id, my_uint_t &answer_id) const
+{
+   // Answers are sorted, so their guess IDs are too
+   const uint32_t *const end{answer_guess_ids + answer_count};
+   const uint32_t *const iter{lower_bound(answer_guess_ids, end, guess_id)};
+
+   if (iter == end || *iter != guess_id)
+      return false;
+
+   answer_id = iter - answer_guess_ids;
+
+   return true;
+}
+
+uint64_t dictionary_t::encode(const string &word) const
+{
+   if (
+         word.size() != length ||
+         ! all_of(word.cbegin(), word.cend(), [](char c){ return c >= 'a' && c <= 'z'; })
+      )
+   {
+      stringstream ss;
+
+      ss << "Invalid word in word list: \"" << word << "\"";
+      throw runtime_error(ss.str());
+   }
+
+   uint64_t code{0};
+
+   for (char c : word)
+      code = (code << BITS_PER_LETTER) | static_cast<uint64_t>(c - 'a');
+
+   return code;
+}
+
+void dictionary_t::unmap()
+{
+   if (mapping != nullptr)
+      munmap(mapping, mapping_size);
+
+   mapping = nullptr;
+   mapping_size = 0;
+
+   guess_codes = nullptr;
+   answer_guess_ids = nullptr;
+   guess_count = 0;
+   answer_count = 0;
+}
+
+string dictionary_t::decode(uint64_t code) const
+{
+   string word(length, 'a');
+
+   for (my_uint_t i{length}; i > 0; --i)
+   {
+      word[i - 1] = 'a' + (code & ((1 << BITS_PER_LETTER) - 1));
+      code >>= BITS_PER_LETTER;
+   }
+
+   return word;
+}
+
+word_list_t::word_list_t(
+                           const dictionary_t &dictionary,
+                           word_kind_t kind,
+                           bool full
+                        ):
+   dictionary{&dictionary},
+   word_kind{kind},
+   members{
+             kind == word_kind_t::guesses ?
+             dictionary.num_guesses() :
+             dictionary.num_answers(),
+             full
+          },
+   num_words{full ? members.size() : 0}
+{
+}
+
+bool word_list_t::contains(const string &word) const
+{
+   my_uint_t id;
+
+   if (word_kind == word_kind_t::guesses ?
+       ! dictionary->find_guess(word, id) :
+       ! dictionary->find_answer(word, id))
+      return false;
+
+   return contains(id);
+}
+
+void word_list_t::insert(my_uint_t id)
+{
+   if (! members.test(id))
+   {
+      members.set(id);
+      ++num_words;
+   }
+}
+
+bool word_list_t::erase(my_uint_t id)
+{
+   if (! members.test(id))
+      return false;
+
+   members.reset(id);
+   --num_words;
+
+   return true;
+}
+
+bool word_list_t::erase(const string &word)
+{
+   my_uint_t id;
+
+   if (word_kind == word_kind_t::guesses ?
+       ! dictionary->find_guess(word, id) :
+       ! dictionary->find_answer(word, id))
+      return false;
+
+   return erase(id);
+}
+
+void word_list_t::intersect(const dynamic_bitset_t &keep)
+{
+   members &= keep;
+   num_words = members.count();
+}
+
+string word_list_t::word(my_uint_t id) const
+{
+   return word_kind == word_kind_t::guesses ?
+          dictionary->guess_word(id) :
+          dictionary->answer_word(id);
+}
+
+my_uint_t word_list_t::first() const
+{
+   const vector<uint64_t> &words{members.words()};
+
+   for (my_uint_t w{0}; w < words.size(); ++w)
+   {
+      if (words[w] != 0)
+         return w * 64 + __builtin_ctzll(words[w]);
+   }
+
+   throw runtime_error("The word list is empty");
+}
+
+vector<uint32_t> word_list_t::ids() const
+{
+   vector<uint32_t> result;
+
+   result.reserve(num_words);
+   members.for_each([&result](my_uint_t id){ result.push_back(id); });
+
+   return result;
+}
+
+word_list_t word_list_t::as_guesses() const
+{
+   if (word_kind == word_kind_t::guesses)
+      return *this;
+
+   word_list_t guesses{*dictionary, word_kind_t::guesses, false};
+
+   members.for_each([&](my_uint_t id){ guesses.insert(dictionary->answer_to_guess(id)); });
+
+   return guesses;
+}
+
+namespace
+{
+   void sort_words(vector<string> &words)
+   {
+      sort(words.begin(), words.end());
+      words.erase(unique(words.begin(), words.end()), words.end());
+   }
+
+   uint64_t hash_word_lists(
+                              my_uint_t word_length,
+                              const vector<string> &guesses,
+                              const vector<string> &answers
+                           )
+   {
+      uint64_t hash{0xcbf29ce484222325};
+
+      auto hash_byte{
+                       [&hash](unsigned char c)
+                       {
+                          hash ^= c;
+                          hash *= 0x100000001b3;
+                       }
+                    };
+
+      hash_byte(word_length);
+
+      for (const auto *words : {&guesses, &answers})
+      {
+         for (const string &word : *words)
+         {
+            for (char c : word)
+               hash_byte(c);
+
+            hash_byte('\n');
+         }
+
+         hash_byte('\0');
+      }
+
+      return hash;
+   }
+
+   uint64_t image_checksum(
+                             my_uint_t word_length,
+                             uint64_t dictionary_hash,
+                             const uint64_t *guess_codes,
+                             my_uint_t num_guesses,
+                             const uint32_t *answer_guess_ids,
+                             my_uint_t num_answers,
+                             const char *names,
+                             my_uint_t names_size
+                          )
+   {
+      uint64_t checksum{mix64(word_length) ^ dictionary_hash};
+
+      checksum = mix64(checksum) ^ num_guesses;
+      checksum = mix64(checksum) ^ num_answers;
+
+      for (my_uint_t g{0}; g < num_guesses; ++g)
+         checksum = mix64(checksum ^ guess_codes[g]);
+
+      for (my_uint_t a{0}; a < num_answers; ++a)
+         checksum = mix64(checksum ^ answer_guess_ids[a]);
+
+      for (my_uint_t i{0}; i < names_size; ++i)
+         checksum = mix64(checksum ^ static_cast<unsigned char>(names[i]));
+
+      return checksum;
+   }
+
+   bool image_size(const image_header_t &header, uint64_t &size)
+   {
+      const uint64_t max_size{UINT64_MAX};
+
+      // Each guess is one code of word_length letters
+      if (header.num_guesses > (max_size - sizeof(header)) / sizeof(uint64_t))
+         return false;
+
+      size = sizeof(header) + header.num_guesses * sizeof(uint64_t);
+
+      if (header.num_answers > (max_size - size) / sizeof(uint32_t))
+         return false;
+
+      size += header.num_answers * sizeof(uint32_t);
+
+      if (header.names_size > max_size - size)
+         return false;
+
+      size += header.names_size;
+
+      return true;
+   }
+}
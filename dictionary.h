@@ -0,0 +1,168 @@
+#ifndef DICTIONARY_INCLUDED
+#define DICTIONARY_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "dynamic_bitset.h"
+#include "type_aliases.h"
+
+// Every allowed guess and every allowed answer, each list sorted and
+// identified by a word's index in it: its guess ID or answer ID. Every
+// answer is also a guess. These IDs are used throughout the program,
+// with the words themselves only needed for input and output.
+//
+// Each word is stored as one integer code, 5 bits per letter with the
+// first letter most significant, so the lists are small contiguous
+// arrays and sorting words sorts their codes. The lists can be saved
+// as a binary image and memory-mapped from it, which is much faster
+// than reading and sorting the text lists.
+class dictionary_t
+{
+   public:
+      dictionary_t();
+      ~dictionary_t();
+
+      dictionary_t(const dictionary_t &) = delete;
+      dictionary_t &operator=(const dictionary_t &) = delete;
+
+      // Replace the lists. Words in answers are added to the guesses.
+      // Throws if any word has a letter other than a to z, or a length
+      // other than that of the first answer.
+      void assign(vector<string> guesses, vector<string> answers);
+
+      // Save the lists to a checksummed image, along with the names of
+      // the word lists they came from
+      void save_image(
+                        const string &filename,
+                        const string &guesses_source,
+                        const string &answers_source
+                     ) const;
+
+      // Replace the lists by mapping an image written by save_image(),
+      // throwing if it is not intact, and get the names of the word
+      // lists it came from
+      void load_image(
+                        const string &filename,
+                        string &guesses_source,
+                        string &answers_source
+                     );
+
+      // Taken from the first answer, or 0 if there are none
+      my_uint_t word_length() const { return length; }
+
+      my_uint_t num_guesses() const { return guess_count; }
+      my_uint_t num_answers() const { return answer_count; }
+
+      string guess_word(my_uint_t guess_id) const { return decode(guess_codes[guess_id]); }
+
+      // One letter of a guess, 0 for 'a', without decoding the rest
+      my_uint_t guess_letter(my_uint_t guess_id, my_uint_t position) const
+      {
+         return (guess_codes[guess_id] >> (BITS_PER_LETTER * (length - 1 - position))) &
+                ((1 << BITS_PER_LETTER) - 1);
+      }
+      string answer_word(my_uint_t answer_id) const { return guess_word(answer_guess_ids[answer_id]); }
+
+      // The IDs of words, which throw if the word is not in the list
+      my_uint_t guess_id(const string &word) const;
+      my_uint_t answer_id(const string &word) const;
+
+      // The same, returning false instead
+      bool find_guess(const string &word, my_uint_t &guess_id) const;
+      bool find_answer(const string &word, my_uint_t &answer_id) const;
+
+      // The same word as a guess
+      my_uint_t answer_to_guess(my_uint_t answer_id) const { return answer_guess_ids[answer_id]; }
+
+      // The same word as an answer, if it is one
+      bool guess_to_answer(my_uint_t guess_id, my_uint_t &answer_id) const;
+
+      // Identifies the word lists: a hash of every word, in order
+      uint64_t hash() const { return word_lists_hash; }
+
+   private:
+      static constexpr my_uint_t BITS_PER_LETTER{5};
+
+      uint64_t encode(const string &word) const;
+      string decode(uint64_t code) const;
+      void unmap();
+
+      my_uint_t length;
+      uint64_t word_lists_hash;
+
+      // The lists, in either the owned vectors or the mapped image
+      const uint64_t *guess_codes;
+      const uint32_t *answer_guess_ids;
+      my_uint_t guess_count;
+      my_uint_t answer_count;
+
+      vector<uint64_t> owned_guess_codes;
+      vector<uint32_t> owned_answer_guess_ids;
+
+      void *mapping;
+      size_t mapping_size;
+};
+
+enum class word_kind_t
+{
+   guesses,
+   answers
+};
+
+// A set of words from one of a dictionary's lists, stored as a bitset
+// over their IDs. The dictionary must outlive it.
+class word_list_t
+{
+   public:
+      // Every word in the list, or none
+      word_list_t(const dictionary_t &dictionary, word_kind_t kind, bool full = true);
+
+      my_uint_t size() const { return num_words; }
+      bool empty() const { return num_words == 0; }
+
+      word_kind_t kind() const { return word_kind; }
+      const dictionary_t &get_dictionary() const { return *dictionary; }
+
+      bool contains(my_uint_t id) const { return members.test(id); }
+      bool contains(const string &word) const;
+
+      void insert(my_uint_t id);
+
+      // Returns false if the word was not in the set
+      bool erase(my_uint_t id);
+      bool erase(const string &word);
+
+      // Remove every word whose bit in keep is clear
+      void intersect(const dynamic_bitset_t &keep);
+
+      // The word with this ID
+      string word(my_uint_t id) const;
+
+      // The member with the lowest ID
+      my_uint_t first() const;
+
+      // Every member's ID, in increasing order
+      vector<uint32_t> ids() const;
+
+      // The same words, as guesses
+      word_list_t as_guesses() const;
+
+      // Call f(id) for every member, in increasing order
+      template <typename F>
+      void for_each(F f) const { members.for_each(f); }
+
+      const dynamic_bitset_t &bits() const { return members; }
+
+   private:
+      const dictionary_t *dictionary;
+      word_kind_t word_kind;
+      dynamic_bitset_t members;
+      my_uint_t num_words;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+#include "dynamic_bitset.h"
+
+dynamic_bitset_t::dynamic_bitset_t(): num_bits{0}
+{
+}
+
+dynamic_bitset_t::dynamic_bitset_t(my_uint_t size, bool value):
+   num_bits{size},
+   bits((size + 63) / 64, value ? ~uint64_t{0} : 0)
+{
+   if (value && size % 64 != 0)
+      bits.back() = (uint64_t{1} << (size % 64)) - 1;
+}
+
+my_uint_t dynamic_bitset_t::count() const
+{
+   my_uint_t total{0};
+
+   for (uint64_t word : bits)
+      total += __builtin_popcountll(word);
+
+   return total;
+}
+
+bool dynamic_bitset_t::any() const
+{
+   for (uint64_t word : bits)
+   {
+      if (word != 0)
+         return true;
+   }
+
+   return false;
+}
+
+dynamic_bitset_t &dynamic_bitset_t::operator&=(const dynamic_bitset_t &other)
+{
+   for (my_uint_t w{0}; w < bits.size(); ++w)
+      bits[w] &= other.bits[w];
+
+   return *this;
+}
+
+dynamic_bitset_t &dynamic_bitset_t::operator|=(const dynamic_bitset_t &other)
+{
+   for (my_uint_t w{0}; w < bits.size(); ++w)
+      bits[w] |= other.bits[w];
+
+   return *this;
+}
+
+dynamic_bitset_t &dynamic_bitset_t::and_not(const dynamic_bitset_t &other)
+{
+   for (my_uint_t w{0}; w < bits.size(); ++w)
+      bits[w] &= ~other.bits[w];
+
+   return *this;
+}
@@ -0,0 +1,58 @@
+#ifndef DYNAMIC_BITSET_INCLUDED
+#define DYNAMIC_BITSET_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+#include "type_aliases.h"
+
+// A fixed-size set of bits chosen at run time, stored as 64-bit words
+// so that set operations work on 64 members at a time. Bits past
+// size() are always zero.
+class dynamic_bitset_t
+{
+   public:
+      dynamic_bitset_t();
+      explicit dynamic_bitset_t(my_uint_t size, bool value = false);
+
+      my_uint_t size() const { return num_bits; }
+      my_uint_t count() const;
+      bool any() const;
+
+      bool test(my_uint_t i) const
+      {
+         return (bits[i / 64] >> (i % 64)) & 1;
+      }
+
+      void set(my_uint_t i) { bits[i / 64] |= uint64_t{1} << (i % 64); }
+      void reset(my_uint_t i) { bits[i / 64] &= ~(uint64_t{1} << (i % 64)); }
+
+      dynamic_bitset_t &operator&=(const dynamic_bitset_t &other);
+      dynamic_bitset_t &operator|=(const dynamic_bitset_t &other);
+
+      // *this &= ~other
+      dynamic_bitset_t &and_not(const dynamic_bitset_t &other);
+
+      bool operator==(const dynamic_bitset_t &other) const = default;
+
+      // Call f(i) for every set bit i, in increasing order
+      template <typename F>
+      void for_each(F f) const
+      {
+         for (my_uint_t w{0}; w < bits.size(); ++w)
+         {
+            for (uint64_t word{bits[w]}; word != 0; word &= word - 1)
+               f(w * 64 + __builtin_ctzll(word));
+         }
+      }
+
+      const vector<uint64_t> &words() const { return bits; }
+
+   private:
+      my_uint_t num_bits;
+      vector<uint64_t> bits;
+};
+
+#endif
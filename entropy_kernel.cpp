@@ -0,0 +1,262 @@
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+#include <immintrin.h>
+
+using namespace std;
+
+#include "entropy_kernel.h"
+
+namespace
+{
+   // Chosen once, based on what the CPU we are running on supports
+   const bool use_avx2{__builtin_cpu_supports("avx2") != 0};
+}
+
+nlog2n_table_t::nlog2n_table_t(my_uint_t max_n): table(max_n + 1), fixed_table(max_n + 1)
+{
+   for (my_uint_t n{1}; n <= max_n; ++n)
+   {
+      table[n] = n * log2(static_cast<double>(n));
+      fixed_table[n] = llround(ldexp(n * log2l(n), FIXED_POINT_BITS));
+   }
+}
+
+double nlog2n_table_t::operator()(my_uint_t n) const
+{
+   if (n < table.size())
+      return table[n];
+
+   return n * log2(static_cast<double>(n));
+}
+
+uint64_t nlog2n_table_t::fixed(my_uint_t n) const
+{
+   if (n < fixed_table.size())
+      return fixed_table[n];
+
+   return llround(ldexp(n * log2l(n), FIXED_POINT_BITS));
+}
+
+template <my_uint_t WORD_LENGTH>
+void entropy_kernel_t<WORD_LENGTH>::pattern_histogram(
+                                                       const pattern_t *row,
+                                                       my_uint_t row_length,
+                                                       const vector<uint32_t> &candidates,
+                                                       histogram_t &histogram
+                                                    )
+{
+   histogram.fill(0);
+
+   (use_avx2 ? pattern_histogram_avx2 : pattern_histogram_scalar)(
+                                                                    row,
+                                                                    row_length,
+                                                                    candidates.data(),
+                                                                    candidates.size(),
+                                                                    histogram.data()
+                                                                 );
+}
+
+template <my_uint_t WORD_LENGTH>
+result_stats_t entropy_kernel_t<WORD_LENGTH>::histogram_stats(
+                                                                const histogram_t &histogram,
+                                                                const nlog2n_table_t &nlog2n
+                                                             )
+{
+   result_stats_t stats{};
+
+   for (uint32_t n : histogram)
+   {
+      stats.sum_nlog2n += nlog2n.fixed(n);
+      stats.sum_squares += uint64_t{n} * n;
+      stats.largest = max(stats.largest, n);
+      stats.buckets += n != 0;
+   }
+
+   return stats;
+}
+
+template <my_uint_t WORD_LENGTH>
+result_stats_t entropy_kernel_t<WORD_LENGTH>::contiguous_stats(
+                                                                 const pattern_t *patterns,
+                                                                 my_uint_t candidate_count,
+                                                                 const nlog2n_table_t &nlog2n,
+                                                                 sparse_histogram_t &histogram
+                                                              )
+{
+   for (my_uint_t i{0}; i < candidate_count; ++i)
+   {
+      const pattern_t pattern{patterns[i]};
+
+      if (histogram.counts[pattern]++ == 0)
+         histogram.used[pattern / 64] |= uint64_t{1} << (pattern % 64);
+   }
+
+   return sparse_stats(histogram, nlog2n);
+}
+
+template <my_uint_t WORD_LENGTH>
+void entropy_kernel_t<WORD_LENGTH>::count_computed_patterns(
+                                                             const char *guess,
+                                                             const letter_columns_t &answers,
+                                                             my_uint_t first,
+                                                             my_uint_t num_answers,
+                                                             sparse_histogram_t &histogram
+                                                          )
+{
+   // Small enough to stay in L1 cache
+   constexpr my_uint_t PATTERNS_PER_BLOCK{256};
+
+   array<pattern_t, PATTERNS_PER_BLOCK> patterns;
+
+   for (my_uint_t start{0}; start < num_answers; start += PATTERNS_PER_BLOCK)
+   {
+      const my_uint_t count{min(PATTERNS_PER_BLOCK, num_answers - start)};
+
+      pattern_kernel_t<WORD_LENGTH>::compute_patterns(guess, answers, first + start, count, patterns.data());
+
+      for (my_uint_t i{0}; i < count; ++i)
+      {
+         const pattern_t pattern{patterns[i]};
+
+         if (histogram.counts[pattern]++ == 0)
+            histogram.used[pattern / 64] |= uint64_t{1} << (pattern % 64);
+      }
+   }
+}
+
+template <my_uint_t WORD_LENGTH>
+result_stats_t entropy_kernel_t<WORD_LENGTH>::sparse_stats(
+                                                             sparse_histogram_t &histogram,
+                                                             const nlog2n_table_t &nlog2n
+                                                          )
+{
+   // Empty bins add nothing to any of the stats
+   result_stats_t stats{};
+
+   for (my_uint_t w{0}; w < histogram.used.size(); ++w)
+   {
+      for (uint64_t bits{histogram.used[w]}; bits != 0; bits &= bits - 1)
+      {
+         uint32_t &count{histogram.counts[w * 64 + countr_zero(bits)]};
+
+         stats.sum_nlog2n += nlog2n.fixed(count);
+         stats.sum_squares += uint64_t{count} * count;
+         stats.largest = max(stats.largest, count);
+         ++stats.buckets;
+         count = 0;
+      }
+
+      histogram.used[w] = 0;
+   }
+
+   return stats;
+}
+
+template <my_uint_t WORD_LENGTH>
+void entropy_kernel_t<WORD_LENGTH>::pattern_histogram_scalar(
+                                                              const pattern_t *row,
+                                                              my_uint_t,
+                                                              const uint32_t *candidates,
+                                                              my_uint_t num_candidates,
+                                                              uint32_t *histogram
+                                                           )
+{
+   for (my_uint_t i{0}; i < num_candidates; ++i)
+      ++histogram[row[candidates[i]]];
+}
+
+template <my_uint_t WORD_LENGTH>
+__attribute__((target("avx2")))
+void entropy_kernel_t<WORD_LENGTH>::pattern_histogram_avx2(
+                                                            const pattern_t *row,
+                                                            my_uint_t row_length,
+                                                            const uint32_t *candidates,
+                                                            my_uint_t num_candidates,
+                                                            uint32_t *histogram
+                                                         )
+{
+   // Gather eight patterns at a time. Each gather reads four bytes, so
+   // stop before any candidate close enough to the end of the row for
+   // that to run past it. Counting into several histograms avoids
+   // stalls when neighboring candidates share a pattern.
+   constexpr my_uint_t LANES{8};
+   constexpr my_uint_t NUM_SUB_HISTOGRAMS{4};
+
+   // Left clear between calls, so that only the bins a call uses need
+   // clearing, rather than all of them for every guess
+   alignas(32) static thread_local uint32_t sub_histograms[NUM_SUB_HISTOGRAMS][NUM_PATTERNS];
+   alignas(32) uint32_t patterns[LANES];
+
+   const __m256i pattern_mask{_mm256_set1_epi32(numeric_limits<pattern_t>::max())};
+   my_uint_t i{0};
+
+   while (
+            i + LANES <= num_candidates &&
+            candidates[i + LANES - 1] * sizeof(pattern_t) + sizeof(uint32_t) <=
+            row_length * sizeof(pattern_t)
+         )
+   {
+      const __m256i indices{
+                              _mm256_loadu_si256(
+                                                   reinterpret_cast<const __m256i *>(candidates + i)
+                                                )
+                           };
+
+      const __m256i gathered{
+                               _mm256_i32gather_epi32(
+                                                        reinterpret_cast<const int *>(row),
+                                                        indices,
+                                                        sizeof(pattern_t)
+                                                     )
+                            };
+
+      _mm256_store_si256(
+                           reinterpret_cast<__m256i *>(patterns),
+                           _mm256_and_si256(gathered, pattern_mask)
+                        );
+
+      for (my_uint_t lane{0}; lane < LANES; ++lane)
+         ++sub_histograms[lane % NUM_SUB_HISTOGRAMS][patterns[lane]];
+
+      i += LANES;
+   }
+
+   // Add the sub-histograms into histogram and clear them again, going
+   // over the gathered candidates' bins or every bin, whichever is less
+   auto fold{
+               [&](pattern_t pattern)
+               {
+                  for (my_uint_t s{0}; s < NUM_SUB_HISTOGRAMS; ++s)
+                  {
+                     histogram[pattern] += sub_histograms[s][pattern];
+                     sub_histograms[s][pattern] = 0;
+                  }
+               }
+            };
+
+   if (i < NUM_PATTERNS)
+   {
+      for (my_uint_t j{0}; j < i; ++j)
+         fold(row[candidates[j]]);
+   }
+   else
+   {
+      for (my_uint_t p{0}; p < NUM_PATTERNS; ++p)
+         fold(p);
+   }
+
+   for (; i < num_candidates; ++i)
+      ++histogram[row[candidates[i]]];
+}
+
+template class entropy_kernel_t<4>;
+template class entropy_kernel_t<5>;
+template class entropy_kernel_t<6>;
+template class entropy_kernel_t<7>;
+template class entropy_kernel_t<8>;
@@ -0,0 +1,139 @@
+#ifndef ENTROPY_KERNEL_INCLUDED
+#define ENTROPY_KERNEL_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+#include "parameters.h"
+#include "pattern_kernel.h"
+#include "type_aliases.h"
+
+// n * log2(n) for every n up to some maximum, so that scoring a
+// histogram needs no calls to log2().
+class nlog2n_table_t
+{
+   public:
+      // fixed() values are scaled by 2^FIXED_POINT_BITS
+      static constexpr int FIXED_POINT_BITS{32};
+
+      explicit nlog2n_table_t(my_uint_t max_n);
+
+      double operator()(my_uint_t n) const;
+
+      // The same in fixed point, so that sums of it are exact whatever
+      // order they are added up in
+      uint64_t fixed(my_uint_t n) const;
+
+   private:
+      vector<double> table;
+      vector<uint64_t> fixed_table;
+};
+
+// Everything a scoring policy needs to know about how one guess splits
+// the candidates, gathered in a single pass over its histogram
+struct result_stats_t
+{
+   // Over every result the guess can get, of the number n of
+   // candidates giving it: the sum of nlog2n_table_t::fixed(n), the
+   // sum of n^2, the largest n and how many results have n > 0
+   uint64_t sum_nlog2n;
+   uint64_t sum_squares;
+   uint32_t largest;
+   uint32_t buckets;
+};
+
+// The entropy scoring loop for words of WORD_LENGTH letters, so that
+// the number of patterns, and with it the size of every histogram, is
+// a constant. It is compiled for every supported word length; use
+// with_word_length() to pick the one for the current word lists.
+template <my_uint_t WORD_LENGTH>
+class entropy_kernel_t
+{
+   public:
+      static constexpr my_uint_t NUM_PATTERNS{num_patterns_for(WORD_LENGTH)};
+
+      // pattern --> number of candidate answers giving that pattern
+      using histogram_t = array<uint32_t, NUM_PATTERNS>;
+
+      // Count, for one guess, how many candidates give each pattern.
+      // row is the guess's row of the pattern matrix (row_length
+      // entries long) and candidates holds ascending answer indices.
+      // The AVX2 version is used when the CPU supports it.
+      static void pattern_histogram(
+                                      const pattern_t *row,
+                                      my_uint_t row_length,
+                                      const vector<uint32_t> &candidates,
+                                      histogram_t &histogram
+                                   );
+
+      static result_stats_t histogram_stats(
+                                              const histogram_t &histogram,
+                                              const nlog2n_table_t &nlog2n
+                                           );
+
+      // A histogram left clear between uses, and a bit for each of its
+      // bins that is in use
+      struct sparse_histogram_t
+      {
+         histogram_t counts{};
+         array<uint64_t, (NUM_PATTERNS + 63) / 64> used{};
+      };
+
+      // The same as histogram_stats() of the histogram of patterns[0]
+      // to patterns[candidate_count - 1], but in time proportional to
+      // candidate_count rather than NUM_PATTERNS. The histogram is left
+      // clear again.
+      static result_stats_t contiguous_stats(
+                                               const pattern_t *patterns,
+                                               my_uint_t candidate_count,
+                                               const nlog2n_table_t &nlog2n,
+                                               sparse_histogram_t &histogram
+                                            );
+
+      // Count into histogram the pattern guess gets against answers
+      // first to first + num_answers - 1 of answers, computing them
+      // with pattern_kernel_t
+      static void count_computed_patterns(
+                                            const char *guess,
+                                            const letter_columns_t &answers,
+                                            my_uint_t first,
+                                            my_uint_t num_answers,
+                                            sparse_histogram_t &histogram
+                                         );
+
+      // The stats of everything counted into histogram so far, which
+      // is left clear again
+      static result_stats_t sparse_stats(
+                                           sparse_histogram_t &histogram,
+                                           const nlog2n_table_t &nlog2n
+                                        );
+
+   private:
+      static void pattern_histogram_scalar(
+                                             const pattern_t *row,
+                                             my_uint_t row_length,
+                                             const uint32_t *candidates,
+                                             my_uint_t num_candidates,
+                                             uint32_t *histogram
+                                          );
+
+      __attribute__((target("avx2")))
+      static void pattern_histogram_avx2(
+                                           const pattern_t *row,
+                                           my_uint_t row_length,
+                                           const uint32_t *candidates,
+                                           my_uint_t num_candidates,
+                                           uint32_t *histogram
+                                        );
+};
+
+extern template class entropy_kernel_t<4>;
+extern template class entropy_kernel_t<5>;
+extern template class entropy_kernel_t<6>;
+extern template class entropy_kernel_t<7>;
+extern template class entropy_kernel_t<8>;
+
+#endif
@@ -1,7 +1,7 @@
 #include <cassert>
 #include <algorithm>
-#include <regex>
-#include <set>
+#include <array>
+#include <string>
 
 using namespace std;
 
@@ -9,9 +9,43 @@ using namespace std;
 
 #include "filter.h"
 
-filter_t::filter_t(): location_unknown_letters(WORD_LENGTH),
-                      known_letters(WORD_LENGTH, '\0')
+filter_index_t::filter_index_t(const pattern_matrix_t &pattern_matrix):
+   pattern_matrix{pattern_matrix},
+   letter_at_bitsets(
+                       parameters.word_length * 26,
+                       dynamic_bitset_t{pattern_matrix.num_answers()}
+                    ),
+   count_at_least_bitsets(
+                            26 * (parameters.word_length + 1),
+                            dynamic_bitset_t{pattern_matrix.num_answers()}
+                         )
 {
+   for (my_uint_t a{0}; a < pattern_matrix.num_answers(); ++a)
+   {
+      const string answer{pattern_matrix.answer_word(a)};
+      array<my_uint_t, 26> letter_count{};
+
+      for (my_uint_t i{0}; i < parameters.word_length; ++i)
+      {
+         letter_at_bitsets[i * 26 + (answer[i] - 'a')].set(a);
+         ++letter_count[answer[i] - 'a'];
+      }
+
+      for (my_uint_t c{0}; c < 26; ++c)
+      {
+         for (my_uint_t count{1}; count <= letter_count[c]; ++count)
+            count_at_least_bitsets[c * (parameters.word_length + 1) + count - 1].set(a);
+      }
+   }
+}
+
+filter_t::filter_t(const filter_index_t &filter_index):
+   filter_index{filter_index},
+   possible_answers{filter_index.get_pattern_matrix().num_answers(), true}
+{
+   allowed_letters.fill((uint32_t{1} << 26) - 1);
+   min_count.fill(0);
+   max_count.fill(parameters.word_length);
 }
 
 void filter_t::filter(
@@ -20,139 +54,97 @@ void filter_t::filter(
                         const string &result
                      )
 {
-   // Build a list of unused letters, location unknown letters,
-   // and location known letters
+   with_word_length(
+                      parameters.word_length,
+                      [&]<my_uint_t WORD_LENGTH>(){ apply<WORD_LENGTH>(guess, result); }
+                   );
+
+   // Keep the word list in step with the bitset
+   answers_filtered.intersect(possible_answers);
+}
 
+template <my_uint_t WORD_LENGTH>
+void filter_t::apply(const string &guess, const string &result)
+{
+   // Update what we know about the answer's letters and positions.
+   //
    // Be careful here! If the answer has N instances of a letter
    // and if we make a guess that has more than N instances of that
    // letter, N instances will be reported as yellow or green, but
-   // the remaining instances will be reported as black. We should
-   // not let that cause us to erroneously add that letter to the
-   // set of unused letters! Furthermore, since we don't have a
-   // guarantee of *which* N instances will be reported as yellow
-   // or green, we must defer the processing of black results until
-   // after all yellow and green results have been processed.
+   // the remaining instances will be reported as black. So a black
+   // square does not mean the letter is unused: it means the answer
+   // has *exactly* as many instances of that letter as were reported
+   // yellow or green. Without any black square for the letter, the
+   // answer has *at least* that many.
+   array<uint8_t, 26> marked_count{};
+   array<bool, 26> marked_black{};
+   const array<uint32_t, MAX_WORD_LENGTH> previously_allowed{allowed_letters};
 
    for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
    {
-      char c{guess[i]};
+      const my_uint_t c{static_cast<my_uint_t>(guess[i] - 'a')};
 
-      if (result[i] == 'b')
-         continue;
-      else if (result[i] == 'y')
-         location_unknown_letters[i].insert(c);
-      else if (result[i] == 'g')
-         known_letters[i] = c;
+      if (result[i] == 'g')
+      {
+         allowed_letters[i] = uint32_t{1} << c;
+         ++marked_count[c];
+      }
       else
-         assert(0);
-   }
-
-   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
-   {
-      if (result[i] == 'b')
       {
-         char c{guess[i]};
-
-         // Check to see if this letter is yellow in *any* other
-         // position before leaving it marked as unused!
-         bool ok_to_mark_unused{true};
-
-         for (const auto &one_set : location_unknown_letters)
-         {
-            if (
-                  any_of(
-                           one_set.cbegin(),
-                           one_set.end(),
-                           [=](char one_char){ return one_char == c; }
-                        )
-               )
-            {
-               ok_to_mark_unused = false;
-            }
-
-            if (! ok_to_mark_unused)
-               break;
-         }
+         allowed_letters[i] &= ~(uint32_t{1} << c);
 
-         if (! ok_to_mark_unused)
-            continue;
-
-         unused_letters.insert(c);
+         if (result[i] == 'y')
+            ++marked_count[c];
+         else if (result[i] == 'b')
+            marked_black[c] = true;
+         else
+            assert(0);
       }
    }
 
-   // Build a regular expression to search for words that meet the criteria
-   // of the letters marked green and to ensure the letters marked yellow
-   // don't appear *in the position they were guessed at*.
-   stringstream search_regex_ss;
-
+   // Apply the new knowledge with whole-bitset AND and AND-NOT
+   // operations. Constraints only ever tighten, so only what changed
+   // this round has to be applied.
    for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
    {
-      if (known_letters[i] == '\0')
-      {
-         search_regex_ss << "[^";
-
-         for (char c : unused_letters)
-            search_regex_ss << c;
+      if (allowed_letters[i] == previously_allowed[i])
+         continue;
 
-         for (char c : location_unknown_letters[i])
-            search_regex_ss << c;
+      if (__builtin_popcount(allowed_letters[i]) == 1)
+      {
+         const char c('a' + __builtin_ctz(allowed_letters[i]));
 
-         search_regex_ss << "]";
+         possible_answers &= filter_index.letter_at(i, c);
       }
       else
-         search_regex_ss << known_letters[i];
-   }
-
-   const regex re(search_regex_ss.str());
-
-   // Use the regular expression to filter the possible answer list.
-   // More filtering will be done later.
-   for (
-          auto iter{answers_filtered.cbegin()};
-          iter != answers_filtered.cend();
-       )
-   {
-      smatch m;
-
-      if (! regex_match(*iter, m, re))
-         iter = answers_filtered.erase(iter);
-      else
-         ++iter;
-   }
-
-   // Ensure that letters that must be present are present
-   set<char> all_location_unknown_letters;
-
-   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
-   {
-      for (char c : location_unknown_letters[i])
       {
-         if (
-               find(
-                      known_letters.cbegin(),
-                      known_letters.cend(),
-                      c
-                   ) ==
-               known_letters.cend()
-            )
+         for (
+                uint32_t removed{previously_allowed[i] & ~allowed_letters[i]};
+                removed != 0;
+                removed &= removed - 1
+             )
          {
-            all_location_unknown_letters.insert(c);
+            const char c('a' + __builtin_ctz(removed));
+
+            possible_answers.and_not(filter_index.letter_at(i, c));
          }
       }
    }
 
-   for (char c : all_location_unknown_letters)
+   for (my_uint_t n{0}; n < 26; ++n)
    {
-      for (
-             auto iter {answers_filtered.cbegin()};
-             iter != answers_filtered.cend();
-         )
+      const char c('a' + n);
+
+      if (marked_count[n] > min_count[n])
       {
-         if (iter->find(c) == string::npos)
-            iter = answers_filtered.erase(iter);
-         else
-            ++iter;
+         min_count[n] = marked_count[n];
+         possible_answers &= filter_index.count_at_least(c, min_count[n]);
+      }
+
+      if (marked_black[n] && marked_count[n] < max_count[n])
+      {
+         max_count[n] = marked_count[n];
+         possible_answers.and_not(filter_index.count_at_least(c, max_count[n] + 1));
       }
    }
 }
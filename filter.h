@@ -1,18 +1,56 @@
 #ifndef FILTER_INCLUDED
 #define FILTER_INCLUDED
 
-#include <set>
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 using namespace std;
 
+#include "dictionary.h"
+#include "dynamic_bitset.h"
+#include "parameters.h"
+#include "pattern_matrix.h"
 #include "type_aliases.h"
 
+// For every answer word, which letter is at each position and how many
+// times each letter occurs, stored as bitsets over answer indices.
+// This is built once and shared by every filter_t.
+class filter_index_t
+{
+   public:
+      explicit filter_index_t(const pattern_matrix_t &pattern_matrix);
+
+      // Answers with letter c at position i
+      const dynamic_bitset_t &letter_at(my_uint_t i, char c) const
+      {
+         return letter_at_bitsets[i * 26 + (c - 'a')];
+      }
+
+      // Answers with at least count instances of letter c, for
+      // 1 <= count <= word length + 1
+      const dynamic_bitset_t &count_at_least(char c, my_uint_t count) const
+      {
+         return count_at_least_bitsets[(c - 'a') * (parameters.word_length + 1) + count - 1];
+      }
+
+      const pattern_matrix_t &get_pattern_matrix() const
+      {
+         return pattern_matrix;
+      }
+
+   private:
+      const pattern_matrix_t &pattern_matrix;
+
+      vector<dynamic_bitset_t> letter_at_bitsets;
+      vector<dynamic_bitset_t> count_at_least_bitsets;
+};
+
 class filter_t
 {
    public:
-      filter_t();
+      explicit filter_t(const filter_index_t &filter_index);
 
       void filter(
                     word_list_t &answers_filtered,
@@ -20,12 +58,25 @@ class filter_t
                     const string &result
                  );
 
+      // Answer indices that are still possible answers
+      const dynamic_bitset_t &candidates() const { return possible_answers; }
+
    private:
-      // Set up member variables to keep track of what we learn about
-      // the answer's letters and their positions.
-      set<char> unused_letters;
-      vector<set<char>> location_unknown_letters;
-      vector<char> known_letters;
+      // Update what we know from one result and apply it to
+      // possible_answers, for words of WORD_LENGTH letters
+      template <my_uint_t WORD_LENGTH>
+      void apply(const string &guess, const string &result);
+
+      const filter_index_t &filter_index;
+
+      // What we have learned about the answer so far: which letters
+      // each position may still hold (bit n is letter 'a' + n) and
+      // bounds on how many times each letter occurs.
+      array<uint32_t, MAX_WORD_LENGTH> allowed_letters;
+      array<uint8_t, 26> min_count;
+      array<uint8_t, 26> max_count;
+
+      dynamic_bitset_t possible_answers;
 };
 
 #endif
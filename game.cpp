@@ -0,0 +1,198 @@
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "game.h"
+#include "parameters.h"
+#include "telemetry.h"
+#include "tools.h"
+
+game_t::game_t(const solver_context_t &context, ostream &out):
+   context{context},
+   out{out},
+   guessed_words_hash{0},
+   all_words_unfiltered{context.all_words},
+   answers_filtered{context.answers},
+   filter{context.filter_index},
+   columns{context.pattern_matrix},
+   current_round{1},
+   is_solved{false}
+{
+   if (telemetry_active())
+      telemetry.game = next_telemetry_game();
+}
+
+string game_t::next_guess(const precomputed_guess_t *precomputed)
+{
+   telemetry_span_t span{telemetry};
+   string guess;
+
+   // With a single answer left there is nothing worth caching
+   const bool use_cache{context.guess_cache != nullptr && answers_filtered.size() > 1};
+   hash128_t key{};
+   uint32_t guess_index;
+
+   if (use_cache)
+      key = state_key();
+
+   if (precomputed != nullptr)
+   {
+      guess = precomputed->guess;
+
+      {
+         telemetry_timer_t timer{telemetry_phase_t::io};
+
+         out << precomputed->output;
+      }
+
+      if (use_cache)
+         context.guess_cache->insert(key, context.pattern_matrix.guess_index(guess));
+   }
+   else if (use_cache && context.guess_cache->find(key, guess_index))
+   {
+      guess = context.pattern_matrix.guess_word(guess_index);
+
+      telemetry_timer_t timer{telemetry_phase_t::io};
+
+      out << "Possible answers remaining: " << answers_filtered.size() << endl;
+      out << "Best guess (previously calculated): " << guess << endl;
+   }
+   else
+   {
+      get_guess(
+                  context,
+                  all_words_unfiltered,
+                  answers_filtered,
+                  current_round,
+                  guess,
+                  out,
+                  &columns
+               );
+
+      if (use_cache)
+         context.guess_cache->insert(key, context.pattern_matrix.guess_index(guess));
+   }
+
+   if (telemetry_active())
+   {
+      telemetry.round = current_round;
+      telemetry.candidates = answers_filtered.size();
+   }
+
+   // Waiting for the user is not part of the round's work
+   span.end();
+
+   // Let the user manually input the guess if that's what they want.
+   // This is useful when solving mutiple puzzles simultaneously.
+   //
+   // This must be done after the code above so that the user knows
+   // what the "best" word is so they can use it if they want to.
+   //
+   // If parameters.manual_mode == false, just use the suggested guess
+   // automatically.
+   if (parameters.manual_mode)
+      get_manual_guess(all_words_unfiltered, guess);
+
+   return guess;
+}
+
+void game_t::submit(const string &guess, const string &result)
+{
+   telemetry_span_t span{telemetry};
+
+   if (telemetry_active())
+   {
+      telemetry.guess = guess;
+      telemetry.buckets = count_buckets(guess);
+   }
+
+   if (result == string(parameters.word_length, 'g'))
+      is_solved = true;
+   else
+   {
+      // Filter the list of possible answers
+      {
+         telemetry_timer_t timer{telemetry_phase_t::filter};
+
+         filter.filter(answers_filtered, guess, result);
+      }
+
+      // Remove the guessed word from our word lists
+      const my_uint_t guess_index{context.pattern_matrix.guess_index(guess)};
+
+      if (all_words_unfiltered.erase(guess_index))
+         guessed_words_hash ^= mix64(guess_index);
+
+      answers_filtered.erase(guess);
+
+      ++current_round;
+   }
+
+   if (telemetry_active())
+   {
+      span.end();
+      write_round_telemetry(telemetry);
+
+      const uint64_t game{telemetry.game};
+
+      telemetry = {};
+      telemetry.game = game;
+   }
+}
+
+string game_t::result_for(const string &target, const string &guess) const
+{
+   const pattern_matrix_t &pattern_matrix{context.pattern_matrix};
+
+   return decode_pattern(
+                           pattern_matrix.pattern(
+                                                    pattern_matrix.guess_index(guess),
+                                                    pattern_matrix.answer_index(target)
+                                                 )
+                        );
+}
+
+my_uint_t game_t::count_buckets(const string &guess) const
+{
+   const pattern_matrix_t &pattern_matrix{context.pattern_matrix};
+   const my_uint_t guess_index{pattern_matrix.guess_index(guess)};
+   vector<bool> seen(parameters.num_patterns, false);
+   my_uint_t buckets{0};
+
+   filter.candidates().for_each(
+                                  [&](my_uint_t answer_index)
+                                  {
+                                     const pattern_t pattern{pattern_matrix.pattern(guess_index, answer_index)};
+
+                                     if (! seen[pattern])
+                                     {
+                                        seen[pattern] = true;
+                                        ++buckets;
+                                     }
+                                  }
+                               );
+
+   return buckets;
+}
+
+hash128_t game_t::state_key() const
+{
+   return hash128(
+                    filter.candidates().words(),
+                    guessed_words_hash ^ mix64(~current_round)
+                 );
+}
+
+my_uint_t play_game(game_t &game, const string &target_word)
+{
+   while (! game.solved() && ! game.failed())
+   {
+      const string guess{game.next_guess()};
+
+      game.submit(guess, game.result_for(target_word, guess));
+   }
+
+   return game.solved() ? game.round() : parameters.rounds + 1;
+}
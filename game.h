@@ -0,0 +1,85 @@
+#ifndef GAME_INCLUDED
+#define GAME_INCLUDED
+
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+#include "candidate_columns.h"
+#include "filter.h"
+#include "hash.h"
+#include "parameters.h"
+#include "solver_context.h"
+#include "telemetry.h"
+#include "type_aliases.h"
+
+// A guess for a game state worked out elsewhere, with what get_guess()
+// wrote while working it out
+struct precomputed_guess_t
+{
+   string guess;
+   string output;
+};
+
+// The state of one game in progress: the words that may still be
+// guessed, the words that may still be the answer and what has been
+// learned so far. The context is shared by every game and must
+// outlive it.
+class game_t
+{
+   public:
+      game_t(const solver_context_t &context, ostream &out);
+
+      my_uint_t round() const { return current_round; }
+      bool solved() const { return is_solved; }
+      bool failed() const { return ! is_solved && current_round > parameters.rounds; }
+
+      const word_list_t &possible_answers() const { return answers_filtered; }
+      const word_list_t &allowed_guesses() const { return all_words_unfiltered; }
+
+      // The recommended guess for the current round. If precomputed is
+      // given, it must have been worked out for this game's current
+      // state, and it is used instead of working the guess out again.
+      string next_guess(const precomputed_guess_t *precomputed = nullptr);
+
+      // Record the result of guessing guess and move on to the next round
+      void submit(const string &guess, const string &result);
+
+      // The result guess would get if target were the answer
+      string result_for(const string &target, const string &guess) const;
+
+      // Identifies everything the recommended guess depends on: the
+      // possible answers, the words already guessed and the round
+      hash128_t state_key() const;
+
+   private:
+      // The number of different results guess can get from the
+      // possible answers
+      my_uint_t count_buckets(const string &guess) const;
+
+      const solver_context_t &context;
+      ostream &out;
+
+      // Order-independent combination of the guessed words' hashes
+      uint64_t guessed_words_hash;
+
+      word_list_t all_words_unfiltered;
+      word_list_t answers_filtered;
+      filter_t filter;
+
+      // The possible answers' patterns, compacted as they dwindle
+      candidate_columns_t columns;
+
+      my_uint_t current_round;
+      bool is_solved;
+
+      // The current round's record, with --telemetry
+      round_telemetry_t telemetry;
+};
+
+// Play a whole game against a known target word, returning the number
+// of rounds it took or parameters.rounds + 1 if the puzzle was not solved.
+my_uint_t play_game(game_t &game, const string &target_word);
+
+#endif
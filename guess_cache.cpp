@@ -0,0 +1,215 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "guess_cache.h"
+#include "parameters.h"
+
+namespace
+{
+   // Bump this whenever the layout of the cache file changes or the
+   // solver changes the way it chooses guesses.
+   constexpr uint32_t CACHE_VERSION{4};
+
+   constexpr char CACHE_MAGIC[8]{'W', 'S', 'G', 'C', 'A', 'C', 'H', 'E'};
+
+   struct cache_header_t
+   {
+      char magic[8];
+      uint32_t version;
+      uint32_t word_length;
+      uint32_t rounds;
+      uint32_t opener_table;
+      uint64_t context_hash;
+      uint64_t num_entries;
+   };
+
+   struct cache_entry_t
+   {
+      uint64_t low;
+      uint64_t high;
+      uint64_t guess_index;
+   };
+
+   cache_header_t expected_header(uint64_t context_hash);
+}
+
+guess_cache_t::guess_cache_t(my_uint_t max_entries):
+   max_entries_per_stripe{(max_entries + NUM_STRIPES - 1) / NUM_STRIPES},
+   hit_count{0},
+   miss_count{0}
+{
+}
+
+bool guess_cache_t::find(const hash128_t &key, uint32_t &guess_index)
+{
+   stripe_t &stripe{stripe_for(key)};
+
+   {
+      lock_guard<mutex> lg{stripe.entries_mutex};
+
+      const auto iter{stripe.entries.find(key)};
+
+      if (iter != stripe.entries.cend())
+      {
+         guess_index = iter->second;
+         ++hit_count;
+
+         return true;
+      }
+   }
+
+   ++miss_count;
+
+   return false;
+}
+
+void guess_cache_t::insert(const hash128_t &key, uint32_t guess_index)
+{
+   stripe_t &stripe{stripe_for(key)};
+   lock_guard<mutex> lg{stripe.entries_mutex};
+
+   if (stripe.entries.size() < max_entries_per_stripe)
+      stripe.entries.insert({key, guess_index});
+}
+
+my_uint_t guess_cache_t::size() const
+{
+   my_uint_t total{0};
+
+   for (const stripe_t &stripe : stripes)
+   {
+      lock_guard<mutex> lg{stripe.entries_mutex};
+      total += stripe.entries.size();
+   }
+
+   return total;
+}
+
+void guess_cache_t::print_stats(ostream &out) const
+{
+   const my_uint_t lookups{hits() + misses()};
+
+   out << "Guess cache: "
+       << size()
+       << " entries, "
+       << hits()
+       << " hits, "
+       << misses()
+       << " misses";
+
+   if (lookups > 0)
+   {
+      out << " ("
+          << fixed
+          << setprecision(1)
+          << 100.0 * hits() / lookups
+          << "% hit rate)";
+   }
+
+   out << endl;
+}
+
+void guess_cache_t::load(const string &filename, uint64_t context_hash, my_uint_t num_guesses)
+{
+   ifstream cache_file{filename, ios::binary};
+
+   if (! cache_file)
+      return;
+
+   cache_header_t header;
+   const cache_header_t expected{expected_header(context_hash)};
+
+   cache_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+   if (
+         ! cache_file ||
+         memcmp(&header, &expected, offsetof(cache_header_t, num_entries)) != 0
+      )
+   {
+      return;
+   }
+
+   cache_entry_t entry;
+
+   for (my_uint_t i{0}; i < header.num_entries; ++i)
+   {
+      if (! cache_file.read(reinterpret_cast<char *>(&entry), sizeof(entry)))
+         break;
+
+      // Only possible if the file is corrupt
+      if (entry.guess_index >= num_guesses)
+         continue;
+
+      insert({entry.low, entry.high}, entry.guess_index);
+   }
+}
+
+void guess_cache_t::save(const string &filename, uint64_t context_hash) const
+{
+   vector<cache_entry_t> entries;
+
+   for (const stripe_t &stripe : stripes)
+   {
+      lock_guard<mutex> lg{stripe.entries_mutex};
+
+      for (const auto &[key, guess_index] : stripe.entries)
+         entries.push_back({key.low, key.high, guess_index});
+   }
+
+   cache_header_t header{expected_header(context_hash)};
+
+   header.num_entries = entries.size();
+
+   // Write to a temporary file first so that a concurrent or
+   // interrupted run never sees a partial cache file.
+   const string temp_filename{temp_filename_for(filename)};
+   ofstream cache_file{temp_filename, ios::binary};
+
+   cache_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+   cache_file.write(
+                      reinterpret_cast<const char *>(entries.data()),
+                      entries.size() * sizeof(cache_entry_t)
+                   );
+
+   cache_file.close();
+
+   if (! cache_file || rename(temp_filename.c_str(), filename.c_str()) != 0)
+   {
+      remove(temp_filename.c_str());
+
+      stringstream ss;
+
+      ss << "Unable to write " << filename;
+      throw runtime_error(ss.str());
+   }
+}
+
+namespace
+{
+   cache_header_t expected_header(uint64_t context_hash)
+   {
+      cache_header_t header{};
+
+      memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+      header.version = CACHE_VERSION;
+      header.word_length = parameters.word_length;
+      header.rounds = parameters.rounds;
+      header.opener_table = USE_OPENER_TABLE;
+      header.context_hash = context_hash;
+
+      return header;
+   }
+}
@@ -0,0 +1,75 @@
+#ifndef GUESS_CACHE_INCLUDED
+#define GUESS_CACHE_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+#include "hash.h"
+#include "parameters.h"
+#include "type_aliases.h"
+
+// Best guess (as a guess index) keyed by a fingerprint of the game
+// state it was chosen for. Many games reach the same set of possible
+// answers, so they can share one cache. The cache is split into
+// independently locked stripes so that threads rarely contend.
+class guess_cache_t
+{
+   public:
+      explicit guess_cache_t(my_uint_t max_entries = GUESS_CACHE_MAX_ENTRIES);
+
+      guess_cache_t(const guess_cache_t &) = delete;
+      guess_cache_t &operator=(const guess_cache_t &) = delete;
+
+      bool find(const hash128_t &key, uint32_t &guess_index);
+
+      // Once the cache is full, new entries are dropped.
+      void insert(const hash128_t &key, uint32_t guess_index);
+
+      my_uint_t hits() const { return hit_count; }
+      my_uint_t misses() const { return miss_count; }
+      my_uint_t size() const;
+
+      void print_stats(ostream &out) const;
+
+      // context_hash identifies the word lists and strategy the
+      // guesses were chosen with. Entries saved with a different
+      // context_hash, or by an incompatible version of the solver, are
+      // ignored when loading, as are guess indexes of num_guesses or
+      // more.
+      void load(const string &filename, uint64_t context_hash, my_uint_t num_guesses);
+      void save(const string &filename, uint64_t context_hash) const;
+
+   private:
+      struct key_hash_t
+      {
+         size_t operator()(const hash128_t &key) const { return key.low; }
+      };
+
+      struct stripe_t
+      {
+         mutable mutex entries_mutex;
+         unordered_map<hash128_t, uint32_t, key_hash_t> entries;
+      };
+
+      static constexpr my_uint_t NUM_STRIPES{64};
+
+      stripe_t &stripe_for(const hash128_t &key)
+      {
+         return stripes[key.high % NUM_STRIPES];
+      }
+
+      const my_uint_t max_entries_per_stripe;
+      array<stripe_t, NUM_STRIPES> stripes;
+
+      atomic<my_uint_t> hit_count;
+      atomic<my_uint_t> miss_count;
+};
+
+#endif
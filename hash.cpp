@@ -0,0 +1,55 @@
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+#include "hash.h"
+
+uint64_t mix64(uint64_t x)
+{
+   x += 0x9e3779b97f4a7c15;
+   x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+   x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+
+   return x ^ (x >> 31);
+}
+
+hash128_t hash128(const vector<uint64_t> &words, uint64_t seed)
+{
+   // Two independent 64-bit chains with different seeds and mixing
+   hash128_t hash{mix64(seed), mix64(~seed)};
+
+   for (uint64_t word : words)
+   {
+      hash.low = mix64(hash.low ^ word);
+      hash.high = mix64(hash.high + ((word << 29) | (word >> 35)));
+   }
+
+   hash.low = mix64(hash.low ^ words.size());
+   hash.high = mix64(hash.high + words.size());
+
+   return hash;
+}
+
+string hashed_filename(const string &prefix, uint64_t hash, const string &suffix)
+{
+   stringstream ss;
+
+   ss << prefix << hex << setw(16) << setfill('0') << hash << suffix;
+
+   return ss.str();
+}
+
+string temp_filename_for(const string &filename)
+{
+   stringstream ss;
+
+   ss << filename << "." << getpid() << ".tmp";
+
+   return ss.str();
+}
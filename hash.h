@@ -0,0 +1,37 @@
+#ifndef HASH_INCLUDED
+#define HASH_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "type_aliases.h"
+
+// A 128-bit fingerprint, wide enough that collisions between the
+// states the solver sees can be ignored.
+struct hash128_t
+{
+   uint64_t low;
+   uint64_t high;
+
+   bool operator==(const hash128_t &other) const = default;
+};
+
+// The splitmix64 finalizer: every input bit affects every output bit
+uint64_t mix64(uint64_t x);
+
+// Fingerprint a sequence of 64-bit words
+hash128_t hash128(const vector<uint64_t> &words, uint64_t seed);
+
+// prefix, then hash as 16 hex digits, then suffix
+string hashed_filename(const string &prefix, uint64_t hash, const string &suffix);
+
+// Where to write a new version of filename before renaming it into
+// place. The name is unique to this process, so that processes sharing
+// a directory never write to the same temporary file.
+string temp_filename_for(const string &filename);
+
+#endif
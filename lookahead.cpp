@@ -0,0 +1,344 @@
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+#include "entropy_kernel.h"
+#include "lookahead.h"
+#include "parameters.h"
+#include "thread_pool.h"
+
+namespace
+{
+   // Values are the total number of guesses needed to solve every
+   // remaining candidate, so that they stay integers. Dividing by the
+   // number of candidates gives the expected number of guesses.
+   constexpr my_uint_t NO_BOUND{numeric_limits<my_uint_t>::max() / 2};
+
+   struct search_t
+   {
+      const pattern_matrix_t &pattern_matrix;
+      const vector<uint32_t> &guess_pool;
+      const nlog2n_table_t &nlog2n;
+      my_uint_t width;
+      atomic<my_uint_t> nodes_expanded;
+   };
+
+   my_uint_t lower_bound_total(my_uint_t num_candidates);
+
+   void top_guesses(
+                      const search_t &search,
+                      const vector<uint32_t> &candidates,
+                      vector<uint32_t> &best
+                   );
+
+   my_uint_t best_total(
+                          search_t &search,
+                          const vector<uint32_t> &candidates,
+                          my_uint_t depth,
+                          my_uint_t bound
+                       );
+
+   my_uint_t guess_total(
+                           search_t &search,
+                           const vector<uint32_t> &candidates,
+                           uint32_t guess,
+                           my_uint_t depth,
+                           my_uint_t bound
+                        );
+}
+
+uint32_t lookahead_guess(
+                           const pattern_matrix_t &pattern_matrix,
+                           const vector<uint32_t> &guess_pool,
+                           const vector<uint32_t> &candidates,
+                           const strategy_t &strategy,
+                           ostream &out,
+                           entropy_t &expected_guesses
+                        )
+{
+   static const nlog2n_table_t nlog2n{pattern_matrix.num_answers()};
+
+   search_t search{pattern_matrix, guess_pool, nlog2n, strategy.lookahead_width, 0};
+
+   vector<uint32_t> roots;
+
+   top_guesses(search, candidates, roots);
+
+   uint32_t guess{roots.front()};
+
+   for (my_uint_t depth{1}; depth <= strategy.lookahead_depth; ++depth)
+   {
+      const auto start_time{chrono::steady_clock::now()};
+
+      search.nodes_expanded = 1;
+
+      // Search below each root guess in parallel. A root guess only
+      // needs an exact value if it might tie or beat the best so far.
+      vector<my_uint_t> totals(roots.size(), NO_BOUND);
+      atomic<my_uint_t> best_so_far{NO_BOUND};
+
+      thread_pool().parallel_for(
+                                   0,
+                                   roots.size(),
+                                   1,
+                                   [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                   {
+                                      for (my_uint_t i{first}; i < last; ++i)
+                                      {
+                                         totals[i] = guess_total(
+                                                                   search,
+                                                                   candidates,
+                                                                   roots[i],
+                                                                   depth,
+                                                                   best_so_far + 1
+                                                                );
+
+                                         my_uint_t best{best_so_far};
+
+                                         while (
+                                                  totals[i] < best &&
+                                                  ! best_so_far.compare_exchange_weak(best, totals[i])
+                                               )
+                                         {
+                                         }
+                                      }
+                                   }
+                                );
+
+      // Ties go to the guess with the higher entropy
+      const my_uint_t best_root(
+                                  min_element(totals.cbegin(), totals.cend()) -
+                                  totals.cbegin()
+                               );
+
+      guess = roots[best_root];
+      expected_guesses = totals[best_root] / static_cast<entropy_t>(candidates.size());
+
+      const chrono::duration<double, milli> elapsed{chrono::steady_clock::now() - start_time};
+      const streamsize precision{out.precision()};
+
+      out << "   Depth "
+          << depth
+          << ": "
+          << pattern_matrix.guess_word(guess)
+          << " ("
+          << expected_guesses
+          << " expected guesses), "
+          << search.nodes_expanded
+          << " nodes expanded in "
+          << fixed
+          << setprecision(1)
+          << elapsed.count()
+          << " ms"
+          << defaultfloat
+          << setprecision(precision)
+          << endl;
+   }
+
+   return guess;
+}
+
+namespace
+{
+   my_uint_t lower_bound_total(my_uint_t num_candidates)
+   {
+      // At best, one candidate is guessed right away and every other
+      // one is guessed right the next time.
+      return num_candidates <= 1 ? num_candidates : 2 * num_candidates - 1;
+   }
+
+   void top_guesses(
+                      const search_t &search,
+                      const vector<uint32_t> &candidates,
+                      vector<uint32_t> &best
+                   )
+   {
+      // Rank by sum(n * log2(n)) over the pattern bins, which orders
+      // guesses the same way as (reversed) entropy. The bins are updated
+      // incrementally so that only the bins actually used are touched.
+      array<uint32_t, MAX_NUM_PATTERNS> bins{};
+      vector<pair<double, uint32_t>> scored;
+      pair<double, uint32_t> best_candidate{numeric_limits<double>::max(), 0};
+
+      scored.reserve(search.guess_pool.size());
+
+      for (uint32_t guess : search.guess_pool)
+      {
+         const pattern_t *row{search.pattern_matrix.row(guess)};
+         double sum{0};
+
+         for (uint32_t candidate : candidates)
+         {
+            const uint32_t n{bins[row[candidate]]++};
+
+            sum += search.nlog2n(n + 1) - search.nlog2n(n);
+         }
+
+         // A guess that matches one of the candidates might itself be
+         // the answer. Remember the best such guess.
+         const bool may_be_answer{bins[parameters.num_patterns - 1] > 0};
+
+         for (uint32_t candidate : candidates)
+            bins[row[candidate]] = 0;
+
+         scored.push_back({sum, guess});
+
+         if (may_be_answer && sum < best_candidate.first)
+            best_candidate = {sum, guess};
+      }
+
+      const my_uint_t width{min(max(search.width, my_uint_t{1}), scored.size())};
+
+      partial_sort(scored.begin(), scored.begin() + width, scored.end());
+
+      best.clear();
+
+      for (my_uint_t i{0}; i < width; ++i)
+         best.push_back(scored[i].second);
+
+      if (
+            best_candidate.first != numeric_limits<double>::max() &&
+            find(best.cbegin(), best.cend(), best_candidate.second) == best.cend()
+         )
+      {
+         best.push_back(best_candidate.second);
+      }
+
+      // Guesses that split the candidates the same way have the same
+      // total, so only the first of them is searched
+      const pattern_matrix_t &pattern_matrix{search.pattern_matrix};
+      my_uint_t num_distinct{0};
+
+      for (uint32_t guess : best)
+      {
+         const bool seen{
+                           any_of(
+                                    best.cbegin(),
+                                    best.cbegin() + num_distinct,
+                                    [&](uint32_t other)
+                                    {
+                                       const pattern_t *const row{pattern_matrix.row(guess)};
+                                       const pattern_t *const other_row{pattern_matrix.row(other)};
+
+                                       return all_of(
+                                                       candidates.cbegin(),
+                                                       candidates.cend(),
+                                                       [&](uint32_t c){ return row[c] == other_row[c]; }
+                                                    );
+                                    }
+                                 )
+                        };
+
+         if (! seen)
+            best[num_distinct++] = guess;
+      }
+
+      best.resize(num_distinct);
+   }
+
+   my_uint_t best_total(
+                          search_t &search,
+                          const vector<uint32_t> &candidates,
+                          my_uint_t depth,
+                          my_uint_t bound
+                       )
+   {
+      // One or two candidates: guess one of them
+      if (candidates.size() <= 2 || depth == 0)
+         return lower_bound_total(candidates.size());
+
+      ++search.nodes_expanded;
+
+      vector<uint32_t> guesses;
+
+      top_guesses(search, candidates, guesses);
+
+      my_uint_t best{bound};
+
+      for (uint32_t guess : guesses)
+         best = min(best, guess_total(search, candidates, guess, depth, best));
+
+      return best;
+   }
+
+   my_uint_t guess_total(
+                           search_t &search,
+                           const vector<uint32_t> &candidates,
+                           uint32_t guess,
+                           my_uint_t depth,
+                           my_uint_t bound
+                        )
+   {
+      // Partition the candidates by the pattern the guess gets
+      const pattern_t *row{search.pattern_matrix.row(guess)};
+      const pattern_t all_green(parameters.num_patterns - 1);
+      array<uint32_t, MAX_NUM_PATTERNS + 1> bin_start;
+
+      fill_n(bin_start.begin(), parameters.num_patterns + 1, 0);
+
+      for (uint32_t candidate : candidates)
+         ++bin_start[row[candidate] + 1];
+
+      for (my_uint_t p{0}; p < parameters.num_patterns; ++p)
+         bin_start[p + 1] += bin_start[p];
+
+      // A guess that cannot tell any of the candidates apart is useless
+      if (bin_start[row[candidates.front()] + 1] - bin_start[row[candidates.front()]] == candidates.size())
+      {
+         if (candidates.size() > 1 || row[candidates.front()] != all_green)
+            return bound;
+      }
+
+      vector<uint32_t> partitioned(candidates.size());
+      array<uint32_t, MAX_NUM_PATTERNS> next;
+
+      copy(bin_start.cbegin(), bin_start.cbegin() + all_green + 1, next.begin());
+
+      for (uint32_t candidate : candidates)
+         partitioned[next[row[candidate]]++] = candidate;
+
+      // Every candidate costs this guess. Those that are not the answer
+      // then cost at least the lower bound for their bin.
+      my_uint_t total{candidates.size()};
+      my_uint_t lower_bound_rest{0};
+
+      for (my_uint_t p{0}; p < all_green; ++p)
+         lower_bound_rest += lower_bound_total(bin_start[p + 1] - bin_start[p]);
+
+      if (total + lower_bound_rest >= bound || depth == 1)
+         return min(total + lower_bound_rest, bound);
+
+      vector<uint32_t> bin;
+
+      for (my_uint_t p{0}; p < all_green; ++p)
+      {
+         const my_uint_t bin_size{bin_start[p + 1] - bin_start[p]};
+
+         if (bin_size == 0)
+            continue;
+
+         lower_bound_rest -= lower_bound_total(bin_size);
+
+         bin.assign(
+                      partitioned.cbegin() + bin_start[p],
+                      partitioned.cbegin() + bin_start[p + 1]
+                   );
+
+         total += best_total(search, bin, depth - 1, bound - total - lower_bound_rest);
+
+         if (total + lower_bound_rest >= bound)
+            return bound;
+      }
+
+      return total;
+   }
+}
@@ -0,0 +1,32 @@
+#ifndef LOOKAHEAD_INCLUDED
+#define LOOKAHEAD_INCLUDED
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+#include "pattern_matrix.h"
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// Choose a guess from guess_pool (guess indices) for the remaining
+// candidates (ascending answer indices) by looking
+// strategy.lookahead_depth guesses ahead. Only the
+// strategy.lookahead_width best guesses by entropy are considered at
+// each step. The guess returned minimizes the expected number of
+// guesses still needed; beyond the search depth that number is
+// estimated by its lower bound. Subtrees that cannot beat the best
+// guess found so far are pruned. Each depth from 1 up is searched in
+// turn, and its time and node count are reported to out.
+uint32_t lookahead_guess(
+                           const pattern_matrix_t &pattern_matrix,
+                           const vector<uint32_t> &guess_pool,
+                           const vector<uint32_t> &candidates,
+                           const strategy_t &strategy,
+                           ostream &out,
+                           entropy_t &expected_guesses
+                        );
+
+#endif
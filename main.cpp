@@ -4,45 +4,258 @@
 
 using namespace std;
 
+#include "batch.h"
+#include "daemon.h"
+#include "decision_tree.h"
+#include "dictionary.h"
 #include "filter.h"
+#include "game.h"
+#include "guess_cache.h"
+#include "hash.h"
+#include "multi_board.h"
+#include "opener_ranking.h"
+#include "opener_table.h"
+#include "optimal_solver.h"
+#include "options.h"
 #include "parameters.h"
+#include "pattern_matrix.h"
+#include "solver_context.h"
+#include "speculator.h"
+#include "telemetry.h"
 #include "tools.h"
 #include "type_aliases.h"
 
 int main(int argc, char *argv[])
 {
-   const string target_word{argc == 2 ? argv[1] : ""};
+   options_t options;
 
-   if (argc > 2)
+   if (! parse_options(argc, argv, options))
+      return 255;
+
+   // Everything else reads the settings from here
+   parameters = options.parameters;
+
+   // Before anything starts the thread pool
+   if (! options.telemetry_filename.empty())
+      open_telemetry(options.telemetry_filename);
+
+   const string &target_word{options.target_word};
+
+   // A saved decision tree holds everything needed to play, so there
+   // is no need to load the word lists.
+   if (! options.play_tree_filename.empty())
+      return play_decision_tree(options.play_tree_filename, target_word);
+
+   // Read the lists of allowed guesses and answers from disk. The
+   // answers decide the word length, and so which version of each
+   // kernel is used.
+   dictionary_t dictionary;
+
+   load_words(dictionary);
+
+   parameters.set_word_length(dictionary.word_length());
+
+   // Partial rankings are checked against the word lists they were
+   // ranked with
+   if (! options.merge_filename.empty())
    {
-      cout << "Usage: " << argv[0] << " [<target word>]" << endl;
-      cout << "   If a target word is supplied, result calculations" << endl;
-      cout << "   will be performed automatically. Otherwise, the" << endl;
-      cout << "   user will have to enter them manually." << endl;
+      merge_opener_rankings(dictionary, options.merge_partial_filenames, options.merge_filename);
+
+      return 0;
+   }
+
+   if (! options.compile_dictionary_filename.empty())
+   {
+      dictionary.save_image(
+                              options.compile_dictionary_filename,
+                              parameters.allowed_guesses_filename,
+                              parameters.allowed_answers_filename
+                           );
+
+      cout << "Dictionary image written to "
+           << options.compile_dictionary_filename
+           << endl;
+
+      return 0;
+   }
+
+   // Sets of all words and of all words that are allowed answers. Each
+   // game takes a copy of these and filters them down as it proceeds.
+   const word_list_t all_words{dictionary, word_kind_t::guesses};
+   const word_list_t answers{dictionary, word_kind_t::answers};
+
+   // Map the result of every guess against every answer, computing it
+   // and caching it on disk the first time these word lists are used.
+   pattern_matrix_t pattern_matrix;
+
+   pattern_matrix.load(dictionary);
 
+   // These search many guesses deep, reading patterns one at a time
+   if (
+         ! pattern_matrix.materialized() &&
+         (
+            options.strategy.lookahead_depth > 0 ||
+            options.strategy.optimal ||
+            options.num_boards > 1
+         )
+      )
+   {
+      cout << "--lookahead, --optimal and --boards need a memory budget large enough for the pattern matrix" << endl;
       cout << endl;
 
       return 255;
    }
 
-   // Load word lists into memory. This is done in a quite space-inefficient
-   // way, but it doesn't harm anything, so leave it since it's the clearest
-   // way to maintain these lists.
+   const filter_index_t filter_index{pattern_matrix};
+
+   // The best first guesses, also worked out and cached on disk the
+   // first time these word lists are used
+   opener_table_t opener_table{pattern_matrix, filter_index, all_words, answers};
+
+   if (options.print_openers)
+   {
+      opener_table.print();
+
+      return 0;
+   }
+
+   // Best guesses already worked out, shared by every game this run plays
+   guess_cache_t guess_cache;
+
+   // Sub-problems already solved, if searching for optimal guesses
+   optimal_solver_t optimal_solver{pattern_matrix, options.strategy.optimal_width};
+
+   const solver_context_t context{
+                                    pattern_matrix,
+                                    filter_index,
+                                    all_words,
+                                    answers,
+                                    options.batch ||
+                                    ! options.build_tree_filename.empty() ||
+                                    ! options.socket_path.empty() ||
+                                    options.persist_guess_cache ?
+                                    &guess_cache :
+                                    nullptr,
+                                    options.strategy,
+                                    options.strategy.optimal ? &optimal_solver : nullptr,
+                                    USE_OPENER_TABLE ? &opener_table : nullptr
+                                 };
+
+   // Saved guesses are only valid for the same word lists and strategy,
+   // and for the same opener when round 1 takes it from the table
+   uint64_t guess_cache_hash{
+                               pattern_matrix.dictionary_hash() ^
+                               options.strategy.fingerprint()
+                            };
 
-   // Create a set of all words.
-   word_list_t all_words_unfiltered;
+   if (options.persist_guess_cache && USE_OPENER_TABLE && options.strategy.policy.is_entropy())
+      guess_cache_hash ^= mix64(~static_cast<uint64_t>(opener_table.best().guess_index));
 
-   // Create a set of all words that are allowed answers. This list
-   // gets filtered down as the game proceeds.
-   word_list_t answers_filtered;
+   const string guess_cache_filename{
+                                       hashed_filename(
+                                                         guess_cache_prefix,
+                                                         guess_cache_hash,
+                                                         ".bin"
+                                                      )
+                                    };
 
-   // Read these two lists of words from disk.
-   load_words(all_words_unfiltered, answers_filtered);
+   if (options.persist_guess_cache)
+      guess_cache.load(guess_cache_filename, guess_cache_hash, pattern_matrix.num_guesses());
+
+   if (parameters.manual_mode)
+   {
+      if (
+            options.batch ||
+            ! options.build_tree_filename.empty() ||
+            ! options.socket_path.empty() ||
+            ! options.rank_openers_filename.empty()
+         )
+      {
+         cout << "Batch, tree building, daemon and ranking modes cannot be used with --manual" << endl;
+         cout << endl;
+
+         return 255;
+      }
+   }
+
+   if (! options.rank_openers_filename.empty())
+   {
+      rank_openers(context, options.shard, options.rank_openers_filename);
+
+      return 0;
+   }
+
+   if (! options.build_tree_filename.empty())
+   {
+      build_decision_tree(context, options.build_tree_filename);
+
+      if (options.persist_guess_cache)
+         guess_cache.save(guess_cache_filename, guess_cache_hash);
+
+      return 0;
+   }
+
+   if (options.num_boards > 1)
+   {
+      for (const string &target : options.board_targets)
+      {
+         if (! answers.contains(target))
+         {
+            cout << "The supplied target word, "
+                 << target
+                 << ", is not an allowed answer word!"
+                 << endl;
+
+            cout << endl;
+
+            return 255;
+         }
+      }
+
+      const my_uint_t rounds{
+                               play_multi_board(
+                                                  context,
+                                                  options.num_boards,
+                                                  options.board_targets
+                                               )
+                            };
+
+      if (options.persist_guess_cache)
+         guess_cache.save(guess_cache_filename, guess_cache_hash);
+
+      return rounds > parameters.rounds ? 254 : rounds;
+   }
+
+   if (! options.socket_path.empty())
+   {
+      const int status{run_daemon(context, options.socket_path)};
+
+      if (options.persist_guess_cache)
+         guess_cache.save(guess_cache_filename, guess_cache_hash);
+
+      return status;
+   }
+
+   if (options.batch)
+   {
+      const my_uint_t failures{
+                                 run_batch(
+                                             context,
+                                             options.batch_targets_filename,
+                                             options.results_filename
+                                          )
+                              };
+
+      if (options.persist_guess_cache)
+         guess_cache.save(guess_cache_filename, guess_cache_hash);
+
+      return failures == 0 ? 0 : 254;
+   }
 
    // Ensure the target_word, if user-supplied, is in the list of allowed answers
    if (target_word != "")
    {
-      if (answers_filtered.find(target_word) == answers_filtered.cend())
+      if (! answers.contains(target_word))
       {
          cout << "The supplied target word, "
               << target_word
@@ -57,56 +270,59 @@ int main(int argc, char *argv[])
 
    // Set up a regular expression to test validity of result inputs
    stringstream result_ss;
-   result_ss << "[byg]{" << WORD_LENGTH << "}";
+   result_ss << "[byg]{" << parameters.word_length << "}";
    const regex result_regex(result_ss.str());
 
    // Proceed with the program's main loop
-   filter_t filter;
-   my_uint_t round{1};
+   game_t game{context, cout};
 
-   for (; round <= ROUNDS; ++round)
+   // Works out the next guess for the likeliest results while the user
+   // is entering the real one
+   speculator_t speculator{context};
+   precomputed_guess_t precomputed;
+   bool have_precomputed{false};
+
+   while (! game.solved() && ! game.failed())
    {
-      cout << "Round " << round << endl;
+      cout << "Round " << game.round() << endl;
 
       // If debugging, save the list of possible answers to disk.
       if constexpr (DEBUG_MODE)
       {
          stringstream ss;
 
-         ss << "answers_filtered_" << round << ".txt";
-         save_word_list(answers_filtered, ss.str());
+         ss << "answers_filtered_" << game.round() << ".txt";
+         save_word_list(game.possible_answers(), ss.str());
       }
 
       // Determine the next guess
-      string guess;
-
-      get_guess(all_words_unfiltered, answers_filtered, round, guess);
+      const string guess{game.next_guess(have_precomputed ? &precomputed : nullptr)};
 
       // Get the result of the user's guess
       string result;
 
       if (target_word != "")
       {
-         result = compare(target_word, guess);
+         result = game.result_for(target_word, guess);
          cout << result << endl;
       }
       else
+      {
+         speculator.start(game, guess);
          get_user_input("Result", result_regex, result);
+         have_precomputed = speculator.finish(result, precomputed);
+      }
 
-      if (result == "ggggg")
-         break;
-
-      // Filter the list of possible answers
-      filter.filter(answers_filtered, guess, result);
-
-      // Remove the guessed word from our word lists
-      all_words_unfiltered.erase(guess);
-      answers_filtered.erase(guess);
+      game.submit(guess, result);
 
-      cout << endl;
+      if (! game.solved())
+         cout << endl;
    }
 
-   if (round == ROUNDS + 1)
+   if (options.persist_guess_cache)
+      guess_cache.save(guess_cache_filename, guess_cache_hash);
+
+   if (game.failed())
    {
       cout << "Could not solve the puzzle!" << endl;
       cout << endl;
@@ -114,5 +330,5 @@ int main(int argc, char *argv[])
       return 254;
    }
 
-   return round;
+   return game.round();
 }
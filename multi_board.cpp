@@ -0,0 +1,372 @@
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+#include "entropy_kernel.h"
+#include "multi_board.h"
+#include "parameters.h"
+#include "scoring_policy.h"
+#include "thread_pool.h"
+#include "tools.h"
+
+namespace
+{
+   // Best first: higher score, then possible answers on some board,
+   // which might solve it outright, then lower guess index, as when
+   // scoring for a single board
+   struct scored_guess_t
+   {
+      double score;
+      uint32_t guess_index;
+      bool possible_answer;
+   };
+
+   // The possible answers of every unsolved board, merged into one list
+   // in ascending answer order so that a guess's row of the pattern
+   // matrix is read once, in order, for all of them.
+   struct merged_candidates_t
+   {
+      vector<uint32_t> answer_indices;
+
+      // Which of the unsolved boards each answer is possible for
+      vector<uint32_t> boards;
+
+      // Number of possible answers on each unsolved board
+      vector<my_uint_t> board_sizes;
+
+      // The possible answers of every unsolved board, as guesses
+      word_list_t guesses;
+   };
+
+   bool better_guess(const scored_guess_t &a, const scored_guess_t &b);
+
+   template <my_uint_t WORD_LENGTH>
+   void score_guesses(
+                        const pattern_matrix_t &pattern_matrix,
+                        const vector<uint32_t> &guess_indices,
+                        my_uint_t first,
+                        my_uint_t last,
+                        const merged_candidates_t &candidates,
+                        const scoring_policy_t &policy,
+                        const nlog2n_table_t &nlog2n,
+                        scored_guess_t &best
+                     );
+}
+
+string get_multi_board_guess(
+                               const solver_context_t &context,
+                               const vector<game_t> &boards,
+                               my_uint_t round,
+                               const word_list_t &guessed,
+                               ostream &out
+                            )
+{
+   const pattern_matrix_t &pattern_matrix{context.pattern_matrix};
+
+   for (my_uint_t b{0}; b < boards.size(); ++b)
+   {
+      if (boards[b].solved())
+         continue;
+
+      if (boards[b].possible_answers().empty())
+      {
+         stringstream ss;
+
+         ss << "No possible answer words remain on board " << b + 1 << ". Something is wrong!";
+         throw runtime_error(ss.str());
+      }
+
+      if (boards[b].possible_answers().size() == 1)
+      {
+         const word_list_t &answers{boards[b].possible_answers()};
+         const string guess{answers.word(answers.first())};
+
+         out << "Only remaining allowed answer word on board "
+             << b + 1
+             << ": "
+             << guess
+             << endl;
+
+         return guess;
+      }
+   }
+
+   // Every board starts out the same, so the first guess is the same
+   // as for a single board.
+   if (round == 1)
+   {
+      string guess;
+
+      get_guess(context, context.all_words, context.answers, round, guess, out);
+
+      return guess;
+   }
+
+   const dictionary_t &dictionary{context.all_words.get_dictionary()};
+   merged_candidates_t candidates{{}, {}, {}, {dictionary, word_kind_t::guesses, false}};
+   vector<pair<uint32_t, uint32_t>> merged;
+
+   for (const game_t &board : boards)
+   {
+      if (board.solved())
+         continue;
+
+      board.possible_answers().for_each(
+                                          [&](my_uint_t answer_index)
+                                          {
+                                             merged.emplace_back(answer_index, candidates.board_sizes.size());
+                                             candidates.guesses.insert(dictionary.answer_to_guess(answer_index));
+                                          }
+                                       );
+
+      candidates.board_sizes.push_back(board.possible_answers().size());
+   }
+
+   sort(merged.begin(), merged.end());
+
+   for (const auto &[answer_index, board] : merged)
+   {
+      candidates.answer_indices.push_back(answer_index);
+      candidates.boards.push_back(board);
+   }
+
+   vector<uint32_t> guess_indices;
+
+   context.all_words.for_each(
+                                [&](my_uint_t guess_index)
+                                {
+                                   if (! guessed.contains(guess_index))
+                                      guess_indices.push_back(guess_index);
+                                }
+                             );
+
+   const scoring_policy_t &policy{context.strategy.policy};
+   static const nlog2n_table_t nlog2n{pattern_matrix.num_answers()};
+
+   // Score small ranges of guesses as pool tasks, each worker keeping
+   // its own best
+   thread_pool_t &pool{thread_pool()};
+   vector<scored_guess_t> best_per_slot(
+                                          pool.size() + 1,
+                                          {-numeric_limits<double>::infinity(), 0, false}
+                                       );
+   constexpr my_uint_t GUESSES_PER_TASK{64};
+
+   pool.parallel_for(
+                       0,
+                       guess_indices.size(),
+                       GUESSES_PER_TASK,
+                       [&](my_uint_t slot, my_uint_t first, my_uint_t last)
+                       {
+                          with_word_length(
+                                             parameters.word_length,
+                                             [&]<my_uint_t WORD_LENGTH>()
+                                             {
+                                                score_guesses<WORD_LENGTH>(
+                                                                             pattern_matrix,
+                                                                             guess_indices,
+                                                                             first,
+                                                                             last,
+                                                                             candidates,
+                                                                             policy,
+                                                                             nlog2n,
+                                                                             best_per_slot[slot]
+                                                                          );
+                                             }
+                                          );
+                       }
+                    );
+
+   const scored_guess_t best{
+                               *min_element(
+                                              best_per_slot.cbegin(),
+                                              best_per_slot.cend(),
+                                              better_guess
+                                           )
+                            };
+
+   const string guess{pattern_matrix.guess_word(best.guess_index)};
+
+   out << "Best guess by combined "
+       << policy.description()
+       << " over "
+       << candidates.board_sizes.size()
+       << " unsolved boards: "
+       << guess
+       << " ("
+       << best.score
+       << ")"
+       << endl;
+
+   return guess;
+}
+
+my_uint_t play_multi_board(
+                             const solver_context_t &context,
+                             my_uint_t num_boards,
+                             const vector<string> &targets
+                          )
+{
+   ostream no_output{nullptr};
+   vector<game_t> boards;
+
+   boards.reserve(num_boards);
+
+   for (my_uint_t b{0}; b < num_boards; ++b)
+      boards.emplace_back(context, no_output);
+
+   stringstream result_ss;
+   result_ss << "[byg]{" << parameters.word_length << "}";
+   const regex result_regex(result_ss.str());
+
+   word_list_t guessed{context.all_words.get_dictionary(), word_kind_t::guesses, false};
+   vector<my_uint_t> solved_in_round(num_boards, 0);
+
+   for (my_uint_t round{1}; round <= parameters.rounds; ++round)
+   {
+      if (all_of(boards.cbegin(), boards.cend(), [](const game_t &board){ return board.solved(); }))
+         break;
+
+      cout << "Round " << round << endl;
+
+      for (my_uint_t b{0}; b < num_boards; ++b)
+      {
+         if (! boards[b].solved())
+         {
+            cout << "Board "
+                 << b + 1
+                 << ": "
+                 << boards[b].possible_answers().size()
+                 << " possible answers"
+                 << endl;
+         }
+      }
+
+      string guess{get_multi_board_guess(context, boards, round, guessed, cout)};
+
+      if (parameters.manual_mode)
+         get_manual_guess(context.all_words, guess);
+
+      guessed.insert(context.pattern_matrix.guess_index(guess));
+
+      for (my_uint_t b{0}; b < num_boards; ++b)
+      {
+         if (boards[b].solved())
+            continue;
+
+         string result;
+
+         if (! targets.empty())
+         {
+            result = boards[b].result_for(targets[b], guess);
+            cout << "Board " << b + 1 << ": " << result << endl;
+         }
+         else
+         {
+            stringstream prompt;
+
+            prompt << "Result for board " << b + 1;
+            get_user_input(prompt.str(), result_regex, result);
+         }
+
+         boards[b].submit(guess, result);
+
+         if (boards[b].solved())
+            solved_in_round[b] = round;
+      }
+
+      cout << endl;
+   }
+
+   for (my_uint_t b{0}; b < num_boards; ++b)
+   {
+      cout << "Board " << b + 1 << ": ";
+
+      if (boards[b].solved())
+         cout << "solved in round " << solved_in_round[b] << endl;
+      else
+         cout << "not solved" << endl;
+   }
+
+   cout << endl;
+
+   if (any_of(solved_in_round.cbegin(), solved_in_round.cend(), [](my_uint_t r){ return r == 0; }))
+   {
+      cout << "Could not solve every puzzle!" << endl;
+      cout << endl;
+
+      return parameters.rounds + 1;
+   }
+
+   return *max_element(solved_in_round.cbegin(), solved_in_round.cend());
+}
+
+namespace
+{
+   bool better_guess(const scored_guess_t &a, const scored_guess_t &b)
+   {
+      if (a.score != b.score)
+         return a.score > b.score;
+
+      if (a.possible_answer != b.possible_answer)
+         return a.possible_answer;
+
+      return a.guess_index < b.guess_index;
+   }
+
+   template <my_uint_t WORD_LENGTH>
+   void score_guesses(
+                        const pattern_matrix_t &pattern_matrix,
+                        const vector<uint32_t> &guess_indices,
+                        my_uint_t first,
+                        my_uint_t last,
+                        const merged_candidates_t &candidates,
+                        const scoring_policy_t &policy,
+                        const nlog2n_table_t &nlog2n,
+                        scored_guess_t &best
+                     )
+   {
+      using kernel_t = entropy_kernel_t<WORD_LENGTH>;
+
+      const my_uint_t num_boards{candidates.board_sizes.size()};
+      vector<typename kernel_t::sparse_histogram_t> histograms(num_boards);
+
+      for (my_uint_t i{first}; i < last; ++i)
+      {
+         const pattern_t *row{pattern_matrix.row(guess_indices[i])};
+
+         for (my_uint_t k{0}; k < candidates.answer_indices.size(); ++k)
+         {
+            auto &histogram{histograms[candidates.boards[k]]};
+            const pattern_t pattern{row[candidates.answer_indices[k]]};
+
+            if (histogram.counts[pattern]++ == 0)
+               histogram.used[pattern / 64] |= uint64_t{1} << (pattern % 64);
+         }
+
+         // The boards' answers are independent, so their scores add, as
+         // entropies do
+         double score{0};
+
+         for (my_uint_t b{0}; b < num_boards; ++b)
+            score += policy.score(kernel_t::sparse_stats(histograms[b], nlog2n), candidates.board_sizes[b]);
+
+         const scored_guess_t scored{
+                                       score,
+                                       guess_indices[i],
+                                       candidates.guesses.contains(guess_indices[i])
+                                    };
+
+         if (better_guess(scored, best))
+            best = scored;
+      }
+   }
+}
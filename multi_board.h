@@ -0,0 +1,41 @@
+#ifndef MULTI_BOARD_INCLUDED
+#define MULTI_BOARD_INCLUDED
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "dictionary.h"
+#include "game.h"
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// The guess to make next when solving several puzzles at once with the
+// same guesses, as in Quordle or Octordle. A board down to one possible
+// answer has it guessed right away. Otherwise the guess chosen is the
+// one scoring best over all unsolved boards together: the sum of its
+// scores under the scoring policy over each board's possible answers,
+// with every board scored in a single pass over the guess's row of the
+// pattern matrix. Ties go to a possible answer on some board. Words
+// already guessed are in guessed.
+string get_multi_board_guess(
+                               const solver_context_t &context,
+                               const vector<game_t> &boards,
+                               my_uint_t round,
+                               const word_list_t &guessed,
+                               ostream &out
+                            );
+
+// Play num_boards boards, prompting for results or computing them
+// against targets (one per board) if it is not empty. Returns the
+// number of rounds taken to solve every board, or parameters.rounds +
+// 1 if some board was not solved.
+my_uint_t play_multi_board(
+                             const solver_context_t &context,
+                             my_uint_t num_boards,
+                             const vector<string> &targets
+                          );
+
+#endif
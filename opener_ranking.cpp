@@ -0,0 +1,584 @@
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "game.h"
+#include "guess_cache.h"
+#include "hash.h"
+#include "opener_ranking.h"
+#include "parameters.h"
+#include "thread_pool.h"
+
+namespace
+{
+   // Bump the version whenever the format of partial files changes or
+   // the way games are played changes.
+   constexpr char MAGIC_LINE[]{"wordle-solver partial opener ranking, version 1"};
+
+   // The openers printed after merging
+   constexpr my_uint_t OPENERS_TO_PRINT{10};
+
+   // Everything a partial file's results depend on. Partial files can
+   // only be merged if they agree on all of it but the shard.
+   struct partial_header_t
+   {
+      uint64_t dictionary_hash;
+      uint64_t strategy_fingerprint;
+      my_uint_t rounds;
+      my_uint_t num_guesses;
+      my_uint_t num_answers;
+      shard_t shard;
+   };
+
+   bool same_job(const partial_header_t &a, const partial_header_t &b);
+
+   // The number of guesses in the shard
+   my_uint_t shard_size(const partial_header_t &header);
+
+   void write_header(ostream &out, const partial_header_t &header);
+   void write_result(ostream &out, const opener_result_t &result);
+
+   // Returns false if in does not start with a valid header
+   bool read_header(istream &in, partial_header_t &header);
+
+   // Read every complete line after the header. A last line cut short
+   // by a crash is ignored; anything else unreadable throws.
+   void read_results(istream &in, const string &filename, vector<opener_result_t> &results);
+
+   // Mark the guess of each of results in done, throwing if it is not
+   // one of the shard's guesses or is marked already
+   void mark_results(
+                       const dictionary_t &dictionary,
+                       const shard_t &shard,
+                       const vector<opener_result_t> &results,
+                       const string &filename,
+                       vector<bool> &done
+                    );
+}
+
+bool parse_shard(const string &text, shard_t &shard)
+{
+   const string::size_type slash{text.find('/')};
+
+   if (slash == string::npos)
+      return false;
+
+   const string index{text.substr(0, slash)};
+   const string count{text.substr(slash + 1)};
+
+   for (const string &number : {index, count})
+   {
+      if (number.empty() || number.size() > 9 || ! all_of(number.cbegin(), number.cend(), ::isdigit))
+         return false;
+   }
+
+   const shard_t parsed{stoul(index), stoul(count)};
+
+   if (parsed.index == 0 || parsed.index > parsed.count)
+      return false;
+
+   shard = parsed;
+
+   return true;
+}
+
+void rank_openers(
+                    const solver_context_t &context,
+                    const shard_t &shard,
+                    const string &partial_filename
+                 )
+{
+   const pattern_matrix_t &pattern_matrix{context.pattern_matrix};
+   const dictionary_t &dictionary{pattern_matrix.get_dictionary()};
+
+   const partial_header_t header{
+                                   pattern_matrix.dictionary_hash(),
+                                   context.strategy.fingerprint(),
+                                   parameters.rounds,
+                                   pattern_matrix.num_guesses(),
+                                   pattern_matrix.num_answers(),
+                                   shard
+                                };
+
+   // Pick up where an earlier run of the same shard left off
+   vector<opener_result_t> results;
+   vector<bool> done(header.num_guesses, false);
+
+   if (ifstream partial_file{partial_filename}; partial_file)
+   {
+      partial_header_t existing;
+
+      if (
+            ! read_header(partial_file, existing) ||
+            ! same_job(existing, header) ||
+            existing.shard.index != shard.index ||
+            existing.shard.count != shard.count
+         )
+      {
+         stringstream ss;
+
+         ss << partial_filename
+            << " holds some other partial ranking; remove it or choose another file";
+
+         throw runtime_error(ss.str());
+      }
+
+      read_results(partial_file, partial_filename, results);
+      mark_results(dictionary, shard, results, partial_filename, done);
+   }
+
+   // Rewrite what was read, dropping any line cut short, so that new
+   // lines can simply be appended
+   const string temp_filename{temp_filename_for(partial_filename)};
+
+   {
+      ofstream temp_file{temp_filename};
+
+      write_header(temp_file, header);
+
+      for (const opener_result_t &result : results)
+         write_result(temp_file, result);
+
+      temp_file.close();
+
+      if (! temp_file || rename(temp_filename.c_str(), partial_filename.c_str()) != 0)
+      {
+         remove(temp_filename.c_str());
+
+         stringstream ss;
+
+         ss << "Unable to write " << partial_filename;
+         throw runtime_error(ss.str());
+      }
+   }
+
+   const my_uint_t num_to_rank{shard_size(header)};
+
+   cout << "Shard " << shard.index << "/" << shard.count << ": "
+        << num_to_rank << " first guesses, "
+        << results.size() << " already ranked" << endl;
+
+   cout << endl;
+
+   vector<string> targets;
+
+   context.answers.for_each([&](my_uint_t id){ targets.push_back(context.answers.word(id)); });
+
+   ofstream partial_file{partial_filename, ios::app};
+
+   for (my_uint_t guess_id{shard.index - 1}; guess_id < header.num_guesses; guess_id += shard.count)
+   {
+      if (done[guess_id])
+         continue;
+
+      const opener_result_t result{play_opener(context, targets, dictionary.guess_word(guess_id))};
+
+      // Flushed at once, so that a crash loses at most this line
+      write_result(partial_file, result);
+
+      if (! partial_file)
+      {
+         stringstream ss;
+
+         ss << "Unable to write " << partial_filename;
+         throw runtime_error(ss.str());
+      }
+
+      results.push_back(result);
+
+      cout << result.word
+           << ": "
+           << fixed
+           << setprecision(6)
+           << average_rounds(result, header.num_answers)
+           << " average rounds, "
+           << result.failures
+           << " not solved ("
+           << results.size()
+           << " of "
+           << num_to_rank
+           << ")"
+           << endl;
+   }
+
+   cout << endl;
+   cout << "Partial ranking written to " << partial_filename << endl;
+   cout << endl;
+}
+
+void merge_opener_rankings(
+                             const dictionary_t &dictionary,
+                             const vector<string> &partial_filenames,
+                             const string &ranking_filename
+                          )
+{
+   vector<partial_header_t> headers;
+   vector<opener_result_t> results;
+
+   // Every guess ranked by any shard so far
+   vector<bool> done(dictionary.num_guesses(), false);
+
+   for (const string &filename : partial_filenames)
+   {
+      ifstream partial_file{filename};
+
+      if (! partial_file)
+      {
+         stringstream ss;
+
+         ss << filename << " is missing";
+         throw runtime_error(ss.str());
+      }
+
+      partial_header_t header;
+
+      if (! read_header(partial_file, header))
+      {
+         stringstream ss;
+
+         ss << filename << " is not a partial opener ranking";
+         throw runtime_error(ss.str());
+      }
+
+      if (header.dictionary_hash != dictionary.hash() || header.num_guesses != dictionary.num_guesses())
+      {
+         stringstream ss;
+
+         ss << filename << " was ranked with other word lists";
+         throw runtime_error(ss.str());
+      }
+
+      if (! headers.empty() && ! same_job(header, headers.front()))
+      {
+         stringstream ss;
+
+         ss << filename
+            << " is from a different job than "
+            << partial_filenames.front()
+            << ": other word lists, strategy or rounds";
+
+         throw runtime_error(ss.str());
+      }
+
+      for (my_uint_t i{0}; i < headers.size(); ++i)
+      {
+         if (headers[i].shard.index == header.shard.index)
+         {
+            stringstream ss;
+
+            ss << filename << " and " << partial_filenames[i] << " are the same shard";
+            throw runtime_error(ss.str());
+         }
+      }
+
+      vector<opener_result_t> shard_results;
+
+      read_results(partial_file, filename, shard_results);
+
+      if (shard_results.size() != shard_size(header))
+      {
+         stringstream ss;
+
+         ss << filename
+            << " is not complete: "
+            << shard_results.size()
+            << " of "
+            << shard_size(header)
+            << " first guesses ranked";
+
+         throw runtime_error(ss.str());
+      }
+
+      mark_results(dictionary, header.shard, shard_results, filename, done);
+
+      headers.push_back(header);
+      results.insert(results.end(), shard_results.cbegin(), shard_results.cend());
+   }
+
+   if (headers.empty() || headers.size() != headers.front().shard.count)
+   {
+      stringstream ss;
+
+      ss << "The job has "
+         << (headers.empty() ? 0 : headers.front().shard.count)
+         << " shards, but "
+         << headers.size()
+         << " partial files were given";
+
+      throw runtime_error(ss.str());
+   }
+
+   // Best first, with the same order whatever order the shards came in
+   sort(
+          results.begin(),
+          results.end(),
+          [](const opener_result_t &a, const opener_result_t &b)
+          {
+             if (a.failures != b.failures)
+                return a.failures < b.failures;
+
+             if (a.total_rounds != b.total_rounds)
+                return a.total_rounds < b.total_rounds;
+
+             return a.word < b.word;
+          }
+       );
+
+   const my_uint_t num_answers{headers.front().num_answers};
+   ofstream ranking_file{ranking_filename};
+
+   for (const opener_result_t &result : results)
+   {
+      ranking_file << result.word
+                   << " "
+                   << fixed
+                   << setprecision(6)
+                   << average_rounds(result, num_answers)
+                   << " "
+                   << result.failures
+                   << endl;
+   }
+
+   ranking_file.close();
+
+   if (! ranking_file)
+   {
+      stringstream ss;
+
+      ss << "Unable to write " << ranking_filename;
+      throw runtime_error(ss.str());
+   }
+
+   cout << "First guesses ranked: " << results.size() << endl;
+   cout << endl;
+   cout << "Best first guesses by average rounds:" << endl;
+
+   for (my_uint_t i{0}; i < min(OPENERS_TO_PRINT, results.size()); ++i)
+   {
+      cout << "   "
+           << results[i].word
+           << ": "
+           << fixed
+           << setprecision(6)
+           << average_rounds(results[i], num_answers)
+           << " ("
+           << results[i].failures
+           << " not solved)"
+           << endl;
+   }
+
+   cout << endl;
+   cout << "Ranking written to " << ranking_filename << endl;
+   cout << endl;
+}
+
+double average_rounds(const opener_result_t &result, my_uint_t num_answers)
+{
+   return result.failures < num_answers ?
+          result.total_rounds / static_cast<double>(num_answers - result.failures) :
+          0;
+}
+
+opener_result_t play_opener(
+                              const solver_context_t &context,
+                              const vector<string> &targets,
+                              const string &opener
+                           )
+{
+   // Games after the same first guess share many states, and no
+   // other games share any of them
+   guess_cache_t guess_cache;
+   solver_context_t opener_context{context};
+
+   opener_context.guess_cache = &guess_cache;
+
+   vector<my_uint_t> rounds(targets.size());
+
+   thread_pool().parallel_for(
+                                0,
+                                targets.size(),
+                                1,
+                                [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                {
+                                   ostream no_output{nullptr};
+
+                                   for (my_uint_t i{first}; i < last; ++i)
+                                   {
+                                      game_t game{opener_context, no_output};
+
+                                      game.submit(opener, game.result_for(targets[i], opener));
+
+                                      rounds[i] = play_game(game, targets[i]);
+                                   }
+                                }
+                             );
+
+   opener_result_t result{opener, 0, 0};
+
+   for (my_uint_t one_game : rounds)
+   {
+      if (one_game > parameters.rounds)
+         ++result.failures;
+      else
+         result.total_rounds += one_game;
+   }
+
+   return result;
+}
+
+namespace
+{
+   bool same_job(const partial_header_t &a, const partial_header_t &b)
+   {
+      return a.dictionary_hash == b.dictionary_hash &&
+             a.strategy_fingerprint == b.strategy_fingerprint &&
+             a.rounds == b.rounds &&
+             a.num_guesses == b.num_guesses &&
+             a.num_answers == b.num_answers &&
+             a.shard.count == b.shard.count;
+   }
+
+   my_uint_t shard_size(const partial_header_t &header)
+   {
+      const shard_t &shard{header.shard};
+
+      if (header.num_guesses < shard.index)
+         return 0;
+
+      return (header.num_guesses - shard.index + shard.count) / shard.count;
+   }
+
+   void write_header(ostream &out, const partial_header_t &header)
+   {
+      out << MAGIC_LINE << endl
+          << hex << setfill('0')
+          << "dictionary " << setw(16) << header.dictionary_hash << endl
+          << "strategy " << setw(16) << header.strategy_fingerprint << endl
+          << dec << setfill(' ')
+          << "rounds " << header.rounds << endl
+          << "guesses " << header.num_guesses << endl
+          << "answers " << header.num_answers << endl
+          << "shard " << header.shard.index << "/" << header.shard.count << endl;
+   }
+
+   void write_result(ostream &out, const opener_result_t &result)
+   {
+      out << result.word << " " << result.total_rounds << " " << result.failures << endl;
+   }
+
+   bool read_header(istream &in, partial_header_t &header)
+   {
+      string line;
+
+      if (! getline(in, line) || line != MAGIC_LINE)
+         return false;
+
+      // key, then how to read its value
+      const auto read_line{
+                             [&](const string &key, auto read_value)
+                             {
+                                string found;
+                                string value;
+
+                                if (! getline(in, line))
+                                   return false;
+
+                                stringstream ss{line};
+
+                                return ss >> found >> value && found == key && read_value(value);
+                             }
+                          };
+
+      const auto read_hex{
+                            [](uint64_t &number)
+                            {
+                               return [&number](const string &value)
+                                      {
+                                         stringstream ss{value};
+
+                                         return ss >> hex >> number && ss.eof();
+                                      };
+                            }
+                         };
+
+      const auto read_count{
+                              [](my_uint_t &number)
+                              {
+                                 return [&number](const string &value)
+                                        {
+                                           stringstream ss{value};
+
+                                           return ss >> number && ss.eof();
+                                        };
+                              }
+                           };
+
+      return read_line("dictionary", read_hex(header.dictionary_hash)) &&
+             read_line("strategy", read_hex(header.strategy_fingerprint)) &&
+             read_line("rounds", read_count(header.rounds)) &&
+             read_line("guesses", read_count(header.num_guesses)) &&
+             read_line("answers", read_count(header.num_answers)) &&
+             read_line("shard", [&](const string &value){ return parse_shard(value, header.shard); });
+   }
+
+   void read_results(istream &in, const string &filename, vector<opener_result_t> &results)
+   {
+      string line;
+
+      // Only a line cut short by a crash is missing its newline
+      while (getline(in, line) && ! in.eof())
+      {
+         stringstream ss{line};
+         opener_result_t result;
+         string rest;
+
+         if (! (ss >> result.word >> result.total_rounds >> result.failures) || ss >> rest)
+         {
+            stringstream error_ss;
+
+            error_ss << filename << " has an invalid line: " << line;
+            throw runtime_error(error_ss.str());
+         }
+
+         results.push_back(result);
+      }
+   }
+
+   void mark_results(
+                       const dictionary_t &dictionary,
+                       const shard_t &shard,
+                       const vector<opener_result_t> &results,
+                       const string &filename,
+                       vector<bool> &done
+                    )
+   {
+      for (const opener_result_t &result : results)
+      {
+         my_uint_t guess_id;
+
+         if (
+               ! dictionary.find_guess(result.word, guess_id) ||
+               guess_id % shard.count != shard.index - 1 ||
+               done[guess_id]
+            )
+         {
+            stringstream ss;
+
+            ss << filename << " has an unexpected entry for " << result.word;
+            throw runtime_error(ss.str());
+         }
+
+         done[guess_id] = true;
+      }
+   }
+}
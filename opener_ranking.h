@@ -0,0 +1,67 @@
+#ifndef OPENER_RANKING_INCLUDED
+#define OPENER_RANKING_INCLUDED
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "dictionary.h"
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// Ranking every allowed guess as a first guess by the average rounds
+// of a full game against every answer takes far too long for one
+// process, so the work is split into shards. Shard index of count
+// ranks the guesses whose index is index - 1 modulo count.
+struct shard_t
+{
+   my_uint_t index{1};
+   my_uint_t count{1};
+};
+
+// One first guess's games against every answer
+struct opener_result_t
+{
+   string word;
+   my_uint_t total_rounds;
+   my_uint_t failures;
+};
+
+// Parse "<index>/<count>", 1 <= index <= count. Returns false if text
+// is invalid.
+bool parse_shard(const string &text, shard_t &shard);
+
+// Play every answer after each of the shard's first guesses and append
+// a line for each to partial_filename as soon as it is done. The file
+// starts with everything that identifies the job, so that it can be
+// merged on its own. If the file already holds part of the same shard,
+// the guesses already done are skipped.
+void rank_openers(
+                    const solver_context_t &context,
+                    const shard_t &shard,
+                    const string &partial_filename
+                 );
+
+// Check that the partial files make up every shard of one job on
+// dictionary's word lists, each complete and holding only its own
+// guesses, and write every first guess to ranking_filename, best
+// first: fewest games not solved, then fewest rounds on average.
+void merge_opener_rankings(
+                             const dictionary_t &dictionary,
+                             const vector<string> &partial_filenames,
+                             const string &ranking_filename
+                          );
+
+// Average rounds over the games solved
+double average_rounds(const opener_result_t &result, my_uint_t num_answers);
+
+// Play a game against each of targets that starts with opener and goes
+// on as context would play it, with a guess cache of its own
+opener_result_t play_opener(
+                              const solver_context_t &context,
+                              const vector<string> &targets,
+                              const string &opener
+                           );
+
+#endif
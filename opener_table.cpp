@@ -0,0 +1,465 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+#include "entropy_kernel.h"
+#include "hash.h"
+#include "opener_ranking.h"
+#include "opener_table.h"
+#include "parameters.h"
+#include "print_mutex.h"
+#include "thread_pool.h"
+#include "tools.h"
+
+namespace
+{
+   // Bump this whenever the layout of the cache file changes or the
+   // way guesses are scored changes.
+   constexpr uint32_t CACHE_VERSION{3};
+
+   constexpr char CACHE_MAGIC[8]{'W', 'S', 'O', 'P', 'E', 'N', 'E', 'R'};
+
+   // Followed by the entries ranked by entropy, then those ranked by
+   // two-ply entropy, then those ranked by rounds
+   struct cache_header_t
+   {
+      char magic[8];
+      uint32_t version;
+      uint32_t word_length;
+      uint64_t dictionary_hash;
+      uint64_t num_guesses;
+      uint64_t num_answers;
+      uint64_t two_ply_width;
+      uint64_t entry_size;
+      uint64_t num_two_ply_entries;
+      uint64_t rounds;
+      uint64_t num_rounds_entries;
+   };
+
+   bool read_cache(
+                     const string &filename,
+                     const cache_header_t &expected_header,
+                     vector<opener_t> &ranked_by_entropy,
+                     vector<opener_t> &ranked_by_two_ply_entropy,
+                     vector<opener_t> &ranked_by_rounds
+                  );
+
+   // Write entries with every padding byte zero, so that the file only
+   // depends on the table
+   void write_entries(ostream &out, const vector<opener_t> &entries);
+
+   entropy_t two_ply_entropy(
+                               const pattern_matrix_t &pattern_matrix,
+                               uint32_t first_guess,
+                               const nlog2n_table_t &nlog2n
+                            );
+}
+
+opener_table_t::opener_table_t(
+                                 const pattern_matrix_t &pattern_matrix,
+                                 const filter_index_t &filter_index,
+                                 const word_list_t &all_words,
+                                 const word_list_t &answers
+                              ): pattern_matrix{pattern_matrix},
+                                 filter_index{filter_index},
+                                 all_words{all_words},
+                                 answers{answers}
+{
+}
+
+void opener_table_t::load_once() const
+{
+   call_once(loaded, [this](){ load(); });
+}
+
+void opener_table_t::load() const
+{
+   const string filename{
+                           hashed_filename(
+                                             opener_table_prefix,
+                                             pattern_matrix.dictionary_hash(),
+                                             ".bin"
+                                          )
+                        };
+
+   cache_header_t header{};
+
+   memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+   header.version = CACHE_VERSION;
+   header.word_length = parameters.word_length;
+   header.dictionary_hash = pattern_matrix.dictionary_hash();
+   header.num_guesses = pattern_matrix.num_guesses();
+   header.num_answers = pattern_matrix.num_answers();
+   header.two_ply_width = OPENER_TWO_PLY_WIDTH;
+   header.entry_size = sizeof(opener_t);
+   header.num_two_ply_entries = min(OPENER_TWO_PLY_WIDTH, pattern_matrix.num_guesses());
+   header.rounds = parameters.rounds;
+   header.num_rounds_entries = min(OPENER_ROUNDS_WIDTH, header.num_two_ply_entries);
+
+   if (read_cache(filename, header, ranked_by_entropy, ranked_by_two_ply_entropy, ranked_by_rounds))
+      return;
+
+   {
+      lock_guard<mutex> lg{print_mutex};
+
+      cout << "Building opener table cache " << filename << endl;
+   }
+
+   // Every guess, by entropy
+   entropy_words_map_t entropies;
+
+   calculate_entropies(pattern_matrix, all_words, answers, entropies);
+
+   ranked_by_entropy.clear();
+
+   for (const auto &[entropy, word] : entropies)
+   {
+      const uint32_t guess_index(pattern_matrix.guess_index(word));
+
+      opener_t opener{};
+
+      opener.guess_index = guess_index;
+      opener.entropy = entropy;
+      ranked_by_entropy.push_back(opener);
+   }
+
+   // The best of those, by two-ply entropy
+   const nlog2n_table_t nlog2n{pattern_matrix.num_answers()};
+
+   for (my_uint_t i{0}; i < header.num_two_ply_entries; ++i)
+   {
+      opener_t &opener{ranked_by_entropy[i]};
+
+      opener.two_ply_entropy = two_ply_entropy(pattern_matrix, opener.guess_index, nlog2n);
+   }
+
+   ranked_by_two_ply_entropy.assign(
+                                      ranked_by_entropy.cbegin(),
+                                      ranked_by_entropy.cbegin() + header.num_two_ply_entries
+                                   );
+
+   stable_sort(
+                 ranked_by_two_ply_entropy.begin(),
+                 ranked_by_two_ply_entropy.end(),
+                 [](const opener_t &a, const opener_t &b)
+                 {
+                    if (a.two_ply_entropy != b.two_ply_entropy)
+                       return a.two_ply_entropy > b.two_ply_entropy;
+
+                    return a.guess_index < b.guess_index;
+                 }
+              );
+
+   // The best of those, by the rounds the solver takes after them. A
+   // small difference in the information a guess gives can go either
+   // way in the games that follow.
+   const solver_context_t context{
+                                    pattern_matrix,
+                                    filter_index,
+                                    all_words,
+                                    answers,
+                                    nullptr,
+                                    {},
+                                    nullptr,
+                                    nullptr
+                                 };
+
+   vector<string> targets;
+
+   answers.for_each([&](my_uint_t id){ targets.push_back(answers.word(id)); });
+
+   for (my_uint_t i{0}; i < header.num_rounds_entries; ++i)
+   {
+      opener_t &opener{ranked_by_two_ply_entropy[i]};
+      const opener_result_t result{
+                                     play_opener(
+                                                   context,
+                                                   targets,
+                                                   pattern_matrix.guess_word(opener.guess_index)
+                                                )
+                                  };
+
+      opener.total_rounds = result.total_rounds;
+      opener.failures = result.failures;
+   }
+
+   ranked_by_rounds.assign(
+                             ranked_by_two_ply_entropy.cbegin(),
+                             ranked_by_two_ply_entropy.cbegin() + header.num_rounds_entries
+                          );
+
+   stable_sort(
+                 ranked_by_rounds.begin(),
+                 ranked_by_rounds.end(),
+                 [](const opener_t &a, const opener_t &b)
+                 {
+                    if (a.failures != b.failures)
+                       return a.failures < b.failures;
+
+                    return a.total_rounds < b.total_rounds;
+                 }
+              );
+
+   // Write to a temporary file first so that a concurrent or
+   // interrupted run never sees a partial cache file.
+   const string temp_filename{temp_filename_for(filename)};
+   ofstream cache_file{temp_filename, ios::binary};
+
+   cache_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+   for (const vector<opener_t> *ranking : {&ranked_by_entropy, &ranked_by_two_ply_entropy, &ranked_by_rounds})
+      write_entries(cache_file, *ranking);
+
+   cache_file.close();
+
+   if (! cache_file || rename(temp_filename.c_str(), filename.c_str()) != 0)
+   {
+      remove(temp_filename.c_str());
+
+      stringstream ss;
+
+      ss << "Unable to write " << filename;
+      throw runtime_error(ss.str());
+   }
+}
+
+const opener_t &opener_table_t::best() const
+{
+   load_once();
+
+   if (ranked_by_entropy.empty())
+      throw runtime_error("The opener table is empty");
+
+   if (! ranked_by_rounds.empty())
+      return ranked_by_rounds.front();
+
+   return ranked_by_two_ply_entropy.empty() ?
+          ranked_by_entropy.front() :
+          ranked_by_two_ply_entropy.front();
+}
+
+void opener_table_t::print() const
+{
+   load_once();
+
+   cout << "Best first guesses by average rounds:" << endl;
+
+   for (const opener_t &opener : ranked_by_rounds)
+   {
+      const opener_result_t result{
+                                     pattern_matrix.guess_word(opener.guess_index),
+                                     opener.total_rounds,
+                                     opener.failures
+                                  };
+
+      cout << result.word
+           << ": "
+           << fixed
+           << setprecision(6)
+           << average_rounds(result, pattern_matrix.num_answers())
+           << " ("
+           << result.failures
+           << " not solved)"
+           << endl;
+   }
+
+   cout << endl;
+
+   entropy_words_map_t entropies;
+
+   cout << "Best first guesses by two-ply entropy:" << endl;
+
+   for (const opener_t &opener : ranked_by_two_ply_entropy)
+      entropies.insert({opener.two_ply_entropy, pattern_matrix.guess_word(opener.guess_index)});
+
+   print_entropies(entropies);
+
+   entropies.clear();
+
+   cout << "Every first guess by entropy:" << endl;
+
+   for (const opener_t &opener : ranked_by_entropy)
+      entropies.insert({opener.entropy, pattern_matrix.guess_word(opener.guess_index)});
+
+   print_entropies(entropies);
+}
+
+namespace
+{
+   bool read_cache(
+                     const string &filename,
+                     const cache_header_t &expected_header,
+                     vector<opener_t> &ranked_by_entropy,
+                     vector<opener_t> &ranked_by_two_ply_entropy,
+                     vector<opener_t> &ranked_by_rounds
+                  )
+   {
+      ifstream cache_file{filename, ios::binary};
+
+      if (! cache_file)
+         return false;
+
+      cache_header_t header;
+
+      cache_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+      if (! cache_file || memcmp(&header, &expected_header, sizeof(header)) != 0)
+         return false;
+
+      ranked_by_entropy.resize(header.num_guesses);
+      ranked_by_two_ply_entropy.resize(header.num_two_ply_entries);
+      ranked_by_rounds.resize(header.num_rounds_entries);
+
+      cache_file.read(
+                        reinterpret_cast<char *>(ranked_by_entropy.data()),
+                        ranked_by_entropy.size() * sizeof(opener_t)
+                     );
+
+      cache_file.read(
+                        reinterpret_cast<char *>(ranked_by_two_ply_entropy.data()),
+                        ranked_by_two_ply_entropy.size() * sizeof(opener_t)
+                     );
+
+      cache_file.read(
+                        reinterpret_cast<char *>(ranked_by_rounds.data()),
+                        ranked_by_rounds.size() * sizeof(opener_t)
+                     );
+
+      // Anything cut short is rebuilt
+      if (! cache_file)
+      {
+         ranked_by_entropy.clear();
+         ranked_by_two_ply_entropy.clear();
+         ranked_by_rounds.clear();
+
+         return false;
+      }
+
+      return true;
+   }
+
+   void write_entries(ostream &out, const vector<opener_t> &entries)
+   {
+      for (const opener_t &entry : entries)
+      {
+         opener_t clean;
+
+         memset(&clean, 0, sizeof(clean));
+         clean.guess_index = entry.guess_index;
+         clean.entropy = entry.entropy;
+         clean.two_ply_entropy = entry.two_ply_entropy;
+         clean.total_rounds = entry.total_rounds;
+         clean.failures = entry.failures;
+
+         out.write(reinterpret_cast<const char *>(&clean), sizeof(clean));
+      }
+   }
+
+   // The Shannon entropy, in bits, of first_guess's results over every
+   // answer, plus that of the best second guess's results over the
+   // answers left by each result, weighted by how likely the result is
+   entropy_t two_ply_entropy(
+                               const pattern_matrix_t &pattern_matrix,
+                               uint32_t first_guess,
+                               const nlog2n_table_t &nlog2n
+                            )
+   {
+      const my_uint_t num_answers{pattern_matrix.num_answers()};
+      vector<pattern_t> first_scratch;
+      const pattern_t *const first_row{pattern_matrix.row(first_guess, first_scratch)};
+
+      // Answers grouped by the result of the first guess
+      vector<uint32_t> grouped(num_answers);
+
+      iota(grouped.begin(), grouped.end(), 0);
+
+      stable_sort(
+                    grouped.begin(),
+                    grouped.end(),
+                    [first_row](uint32_t a, uint32_t b){ return first_row[a] < first_row[b]; }
+                 );
+
+      // [start, end) of each group that a second guess can split
+      vector<pair<my_uint_t, my_uint_t>> groups;
+      double first_sum{0};
+
+      for (my_uint_t start{0}, end{0}; start < num_answers; start = end)
+      {
+         while (end < num_answers && first_row[grouped[end]] == first_row[grouped[start]])
+            ++end;
+
+         first_sum += nlog2n(end - start);
+
+         if (end - start > 1)
+            groups.push_back({start, end});
+      }
+
+      // The best entropy found for each group, by each worker
+      thread_pool_t &pool{thread_pool()};
+      vector<vector<double>> best_per_slot(pool.size() + 1, vector<double>(groups.size(), 0));
+
+      pool.parallel_for(
+                          0,
+                          pattern_matrix.num_guesses(),
+                          64,
+                          [&](my_uint_t slot, my_uint_t first, my_uint_t last)
+                          {
+                             vector<uint32_t> counts(parameters.num_patterns, 0);
+                             vector<double> &best{best_per_slot[slot]};
+                             vector<pattern_t> scratch;
+
+                             for (my_uint_t g{first}; g < last; ++g)
+                             {
+                                const pattern_t *const row{pattern_matrix.row(g, scratch)};
+
+                                for (my_uint_t i{0}; i < groups.size(); ++i)
+                                {
+                                   const auto [start, end] = groups[i];
+                                   double sum{0};
+
+                                   for (my_uint_t j{start}; j < end; ++j)
+                                      ++counts[row[grouped[j]]];
+
+                                   // Clearing only the counts used is much
+                                   // cheaper than clearing all of them
+                                   for (my_uint_t j{start}; j < end; ++j)
+                                   {
+                                      uint32_t &count{counts[row[grouped[j]]]};
+
+                                      sum += nlog2n(count);
+                                      count = 0;
+                                   }
+
+                                   best[i] = max(best[i], (nlog2n(end - start) - sum) / (end - start));
+                                }
+                             }
+                          }
+                       );
+
+      entropy_t second{0};
+
+      for (my_uint_t i{0}; i < groups.size(); ++i)
+      {
+         double best{0};
+
+         for (const auto &one_slot : best_per_slot)
+            best = max(best, one_slot[i]);
+
+         second += best * (groups[i].second - groups[i].first) / num_answers;
+      }
+
+      return (nlog2n(num_answers) - first_sum) / num_answers + second;
+   }
+}
@@ -0,0 +1,88 @@
+#ifndef OPENER_TABLE_INCLUDED
+#define OPENER_TABLE_INCLUDED
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+#include "dictionary.h"
+#include "filter.h"
+#include "pattern_matrix.h"
+#include "type_aliases.h"
+
+struct opener_t
+{
+   uint32_t guess_index;
+
+   // As calculate_entropies() scores the guess in round 1
+   entropy_t entropy;
+
+   // The bits of information expected from this guess followed by the
+   // best second guess for its result, or 0 if it was not ranked by it
+   entropy_t two_ply_entropy;
+
+   // The rounds taken by the games solved and the number not solved
+   // when the solver plays every answer after this guess, or 0 if it
+   // was not ranked by them
+   uint32_t total_rounds;
+   uint32_t failures;
+};
+
+// Every allowed guess ranked as a first guess, for one pair of word
+// lists, so that the first round needs no scoring. The
+// OPENER_TWO_PLY_WIDTH best by entropy are also ranked by two-ply
+// entropy, and the OPENER_ROUNDS_WIDTH best of those by the rounds the
+// solver takes after them, which is what the best opener is chosen
+// by. Building the table takes a while, so it is cached on disk under
+// a hash of the word lists, and only read or built the first time it
+// is used.
+class opener_table_t
+{
+   public:
+      // Everything passed must outlive the table
+      opener_table_t(
+                       const pattern_matrix_t &pattern_matrix,
+                       const filter_index_t &filter_index,
+                       const word_list_t &all_words,
+                       const word_list_t &answers
+                    );
+
+      opener_table_t(const opener_table_t &) = delete;
+      opener_table_t &operator=(const opener_table_t &) = delete;
+
+      // Best first, with ties going to the lower guess index
+      const vector<opener_t> &by_entropy() const { load_once(); return ranked_by_entropy; }
+      const vector<opener_t> &by_two_ply_entropy() const { load_once(); return ranked_by_two_ply_entropy; }
+
+      // Fewest games not solved first, then fewest rounds, with ties
+      // going to the better by two-ply entropy
+      const vector<opener_t> &by_rounds() const { load_once(); return ranked_by_rounds; }
+
+      // The best by rounds, or by the best ranking there is if none are
+      // ranked by rounds
+      const opener_t &best() const;
+
+      // Every ranking, one "word: score" line per guess
+      void print() const;
+
+   private:
+      // Read the table from its cache file, building it and saving the
+      // cache file first if there is none, unless that has been done
+      // already. Safe to call from any number of threads at once.
+      void load_once() const;
+      void load() const;
+
+      const pattern_matrix_t &pattern_matrix;
+      const filter_index_t &filter_index;
+      const word_list_t &all_words;
+      const word_list_t &answers;
+
+      mutable once_flag loaded;
+      mutable vector<opener_t> ranked_by_entropy;
+      mutable vector<opener_t> ranked_by_two_ply_entropy;
+      mutable vector<opener_t> ranked_by_rounds;
+};
+
+#endif
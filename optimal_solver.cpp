@@ -0,0 +1,409 @@
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+#include "optimal_solver.h"
+#include "parameters.h"
+#include "thread_pool.h"
+
+namespace
+{
+   // Totals are the number of guesses summed over every candidate, so
+   // that they stay integers. Anything at or above NO_BOUND means the
+   // candidates cannot all be solved in the rounds left.
+   constexpr my_uint_t NO_BOUND{numeric_limits<my_uint_t>::max() / 4};
+
+   constexpr uint32_t NO_GUESS{UINT32_MAX};
+
+   my_uint_t lower_bound_total(my_uint_t num_candidates);
+
+   hash128_t state_key(const vector<uint32_t> &candidates, my_uint_t rounds_left);
+}
+
+optimal_solver_t::optimal_solver_t(
+                                     const pattern_matrix_t &pattern_matrix,
+                                     my_uint_t width
+                                  ): pattern_matrix{pattern_matrix},
+                                     width{width},
+                                     nlog2n{pattern_matrix.num_answers()},
+                                     nodes_expanded{0}
+{
+}
+
+uint32_t optimal_solver_t::best_guess(
+                                        const vector<uint32_t> &candidates,
+                                        my_uint_t rounds_left,
+                                        ostream &out,
+                                        my_uint_t &total_guesses
+                                     )
+{
+   if (candidates.size() == 1)
+   {
+      total_guesses = 1;
+
+      return pattern_matrix.guess_index(pattern_matrix.answer_word(candidates.front()));
+   }
+
+   const hash128_t key{state_key(candidates, rounds_left)};
+   entry_t entry;
+
+   if (find(key, entry) && entry.exact)
+   {
+      total_guesses = entry.total;
+
+      return entry.guess_index;
+   }
+
+   const auto start_time{chrono::steady_clock::now()};
+   const my_uint_t nodes_before{nodes_expanded};
+
+   ++nodes_expanded;
+
+   vector<uint32_t> guesses;
+
+   rank_guesses(candidates, guesses);
+
+   // Search below each guess in parallel. A guess only needs an exact
+   // total if it might tie or beat the best so far; ties go to the
+   // guess with the higher entropy.
+   vector<my_uint_t> totals(guesses.size(), NO_BOUND);
+   atomic<my_uint_t> best_so_far{NO_BOUND};
+
+   thread_pool().parallel_for(
+                                0,
+                                guesses.size(),
+                                1,
+                                [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                {
+                                   for (my_uint_t i{first}; i < last; ++i)
+                                   {
+                                      totals[i] = guess_total(
+                                                                candidates,
+                                                                guesses[i],
+                                                                rounds_left,
+                                                                best_so_far + 1
+                                                             );
+
+                                      my_uint_t best{best_so_far};
+
+                                      while (
+                                               totals[i] < best &&
+                                               ! best_so_far.compare_exchange_weak(best, totals[i])
+                                            )
+                                      {
+                                      }
+                                   }
+                                }
+                             );
+
+   const my_uint_t best{
+                          static_cast<my_uint_t>(
+                                                   min_element(totals.cbegin(), totals.cend()) -
+                                                   totals.cbegin()
+                                                )
+                       };
+
+   if (guesses.empty() || totals[best] >= NO_BOUND)
+   {
+      stringstream ss;
+
+      ss << "No guess solves all "
+         << candidates.size()
+         << " remaining answers within "
+         << rounds_left
+         << " rounds";
+
+      throw runtime_error(ss.str());
+   }
+
+   store(key, {totals[best], true, guesses[best]});
+
+   total_guesses = totals[best];
+
+   const chrono::duration<double> elapsed{chrono::steady_clock::now() - start_time};
+   const streamsize precision{out.precision()};
+
+   my_uint_t num_states{0};
+
+   for (stripe_t &stripe : stripes)
+   {
+      lock_guard<mutex> lg{stripe.entries_mutex};
+
+      num_states += stripe.entries.size();
+   }
+
+   out << "   Optimal search: "
+       << nodes_expanded - nodes_before
+       << " nodes expanded in "
+       << fixed
+       << setprecision(2)
+       << elapsed.count()
+       << " s, "
+       << num_states
+       << " states remembered"
+       << defaultfloat
+       << setprecision(precision)
+       << endl;
+
+   return guesses[best];
+}
+
+bool optimal_solver_t::find(const hash128_t &key, entry_t &entry)
+{
+   stripe_t &stripe{stripes[key.high % NUM_STRIPES]};
+   lock_guard<mutex> lg{stripe.entries_mutex};
+
+   const auto iter{stripe.entries.find(key)};
+
+   if (iter == stripe.entries.cend())
+      return false;
+
+   entry = iter->second;
+
+   return true;
+}
+
+void optimal_solver_t::store(const hash128_t &key, const entry_t &entry)
+{
+   stripe_t &stripe{stripes[key.high % NUM_STRIPES]};
+   lock_guard<mutex> lg{stripe.entries_mutex};
+
+   const auto [iter, inserted]{stripe.entries.insert({key, entry})};
+
+   // Never replace an exact total, and keep the higher lower bound
+   if (! inserted && ! iter->second.exact && (entry.exact || entry.total > iter->second.total))
+      iter->second = entry;
+}
+
+void optimal_solver_t::rank_guesses(
+                                      const vector<uint32_t> &candidates,
+                                      vector<uint32_t> &guesses
+                                   ) const
+{
+   const pattern_t all_green(parameters.num_patterns - 1);
+
+   // (sum(n * log2(n)) over the pattern bins, guess index, split
+   // fingerprint, whether the guess might be the answer). Lower sums
+   // mean higher entropy.
+   vector<tuple<double, uint32_t, uint64_t, bool>> scored;
+   array<uint32_t, MAX_NUM_PATTERNS> bins{};
+   array<uint32_t, MAX_NUM_PATTERNS> labels{};
+
+   scored.reserve(pattern_matrix.num_guesses());
+
+   for (uint32_t guess_index{0}; guess_index < pattern_matrix.num_guesses(); ++guess_index)
+   {
+      const pattern_t *row{pattern_matrix.row(guess_index)};
+      double sum{0};
+      my_uint_t num_bins{0};
+
+      // Fingerprint how the guess splits the candidates, ignoring which
+      // pattern each bin gets, except for the one that ends the game
+      uint64_t split{0};
+
+      for (uint32_t candidate : candidates)
+      {
+         const pattern_t pattern{row[candidate]};
+         const uint32_t n{bins[pattern]++};
+
+         sum += nlog2n(n + 1) - nlog2n(n);
+
+         if (n == 0)
+            labels[pattern] = pattern == all_green ? UINT32_MAX : ++num_bins;
+
+         split = mix64(split ^ labels[pattern]);
+      }
+
+      const bool may_be_answer{bins[all_green] > 0};
+
+      for (uint32_t candidate : candidates)
+         bins[row[candidate]] = 0;
+
+      // A guess that cannot tell any of the candidates apart is useless
+      if (num_bins > 1 || may_be_answer)
+         scored.emplace_back(sum, guess_index, split, may_be_answer);
+   }
+
+   sort(scored.begin(), scored.end());
+
+   // Of the guesses that split the candidates the same way, only the
+   // best ranked one needs to be tried. When the width is limited, the
+   // best guess that might itself be the answer is still tried.
+   unordered_set<uint64_t> splits_seen;
+   bool candidate_tried{false};
+
+   guesses.clear();
+
+   for (const auto &[sum, guess_index, split, may_be_answer] : scored)
+   {
+      if (width != 0 && guesses.size() >= width)
+      {
+         if (candidate_tried)
+            break;
+
+         if (! may_be_answer)
+            continue;
+      }
+
+      if (! splits_seen.insert(split).second)
+         continue;
+
+      guesses.push_back(guess_index);
+      candidate_tried = candidate_tried || may_be_answer;
+   }
+}
+
+my_uint_t optimal_solver_t::solve(
+                                    const vector<uint32_t> &candidates,
+                                    my_uint_t rounds_left,
+                                    my_uint_t bound
+                                 )
+{
+   if (rounds_left == 0)
+      return NO_BOUND;
+
+   if (candidates.size() == 1)
+      return 1;
+
+   if (rounds_left == 1)
+      return NO_BOUND;
+
+   // Guess one of the two, then the other if need be
+   if (candidates.size() == 2)
+      return 3;
+
+   if (lower_bound_total(candidates.size()) >= bound)
+      return bound;
+
+   const hash128_t key{state_key(candidates, rounds_left)};
+   entry_t entry;
+
+   if (find(key, entry) && (entry.exact || entry.total >= bound))
+      return entry.total;
+
+   ++nodes_expanded;
+
+   vector<uint32_t> guesses;
+
+   rank_guesses(candidates, guesses);
+
+   my_uint_t best{bound};
+   uint32_t best_guess_index{NO_GUESS};
+
+   for (uint32_t guess_index : guesses)
+   {
+      const my_uint_t total{guess_total(candidates, guess_index, rounds_left, best)};
+
+      if (total < best)
+      {
+         best = total;
+         best_guess_index = guess_index;
+      }
+   }
+
+   // If nothing beat the bound, all that is known is that the total is
+   // at least the bound.
+   store(key, {best, best_guess_index != NO_GUESS, best_guess_index});
+
+   return best;
+}
+
+my_uint_t optimal_solver_t::guess_total(
+                                          const vector<uint32_t> &candidates,
+                                          uint32_t guess_index,
+                                          my_uint_t rounds_left,
+                                          my_uint_t bound
+                                       )
+{
+   // Partition the candidates by the pattern the guess gets
+   const pattern_t *row{pattern_matrix.row(guess_index)};
+   const pattern_t all_green(parameters.num_patterns - 1);
+   array<uint32_t, MAX_NUM_PATTERNS + 1> bin_start;
+
+   fill_n(bin_start.begin(), parameters.num_patterns + 1, 0);
+
+   for (uint32_t candidate : candidates)
+      ++bin_start[row[candidate] + 1];
+
+   for (my_uint_t p{0}; p < parameters.num_patterns; ++p)
+      bin_start[p + 1] += bin_start[p];
+
+   // Every candidate costs this guess. Those that are not the answer
+   // then cost at least the lower bound for their bin.
+   my_uint_t total{candidates.size()};
+   my_uint_t lower_bound_rest{0};
+
+   for (my_uint_t p{0}; p < all_green; ++p)
+      lower_bound_rest += lower_bound_total(bin_start[p + 1] - bin_start[p]);
+
+   if (total + lower_bound_rest >= bound)
+      return bound;
+
+   // Only the answer itself can be solved by a last guess
+   if (rounds_left == 1)
+      return lower_bound_rest == 0 ? total : NO_BOUND;
+
+   vector<uint32_t> partitioned(candidates.size());
+   array<uint32_t, MAX_NUM_PATTERNS> next;
+
+   copy(bin_start.cbegin(), bin_start.cbegin() + all_green + 1, next.begin());
+
+   for (uint32_t candidate : candidates)
+      partitioned[next[row[candidate]]++] = candidate;
+
+   vector<uint32_t> bin;
+
+   for (my_uint_t p{0}; p < all_green; ++p)
+   {
+      const my_uint_t bin_size{bin_start[p + 1] - bin_start[p]};
+
+      if (bin_size == 0)
+         continue;
+
+      lower_bound_rest -= lower_bound_total(bin_size);
+
+      bin.assign(
+                   partitioned.cbegin() + bin_start[p],
+                   partitioned.cbegin() + bin_start[p + 1]
+                );
+
+      total += solve(bin, rounds_left - 1, bound - total - lower_bound_rest);
+
+      if (total + lower_bound_rest >= bound)
+         return bound;
+   }
+
+   return total;
+}
+
+namespace
+{
+   my_uint_t lower_bound_total(my_uint_t num_candidates)
+   {
+      // At best, one candidate is guessed right away and every other
+      // one is guessed right the next time.
+      return num_candidates <= 1 ? num_candidates : 2 * num_candidates - 1;
+   }
+
+   hash128_t state_key(const vector<uint32_t> &candidates, my_uint_t rounds_left)
+   {
+      vector<uint64_t> words((candidates.size() + 1) / 2, 0);
+
+      for (my_uint_t i{0}; i < candidates.size(); ++i)
+         words[i / 2] |= static_cast<uint64_t>(candidates[i]) << (32 * (i % 2));
+
+      return hash128(words, mix64(rounds_left));
+   }
+}
@@ -0,0 +1,101 @@
+#ifndef OPTIMAL_SOLVER_INCLUDED
+#define OPTIMAL_SOLVER_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+#include "entropy_kernel.h"
+#include "hash.h"
+#include "pattern_matrix.h"
+#include "type_aliases.h"
+
+// Finds the guess that minimizes the expected number of guesses needed
+// to solve every remaining candidate within the rounds left. The search
+// is exhaustive over every allowed guess. Guesses are tried best entropy
+// first, and any subtree whose lower bound cannot beat the best
+// alternative is pruned. Guesses that split the candidates the same way
+// are tried only once. Every sub-problem solved is remembered in a
+// transposition table shared by all threads, so later games reach
+// solved states without searching again.
+//
+// With a non-zero width, only the width best guesses by entropy (plus
+// the best guess that might be the answer) are tried at each step. The
+// result is then no longer guaranteed optimal, but takes far less time.
+class optimal_solver_t
+{
+   public:
+      optimal_solver_t(const pattern_matrix_t &pattern_matrix, my_uint_t width);
+
+      optimal_solver_t(const optimal_solver_t &) = delete;
+      optimal_solver_t &operator=(const optimal_solver_t &) = delete;
+
+      // candidates holds ascending answer indices. Returns the best
+      // guess index and sets total_guesses to the number of guesses,
+      // summed over every candidate, that it takes to solve them all
+      // with rounds_left guesses.
+      uint32_t best_guess(
+                            const vector<uint32_t> &candidates,
+                            my_uint_t rounds_left,
+                            ostream &out,
+                            my_uint_t &total_guesses
+                         );
+
+   private:
+      struct entry_t
+      {
+         // The exact total when exact is set, otherwise a lower bound
+         my_uint_t total;
+         bool exact;
+         uint32_t guess_index;
+      };
+
+      struct key_hash_t
+      {
+         size_t operator()(const hash128_t &key) const { return key.low; }
+      };
+
+      struct stripe_t
+      {
+         mutex entries_mutex;
+         unordered_map<hash128_t, entry_t, key_hash_t> entries;
+      };
+
+      static constexpr my_uint_t NUM_STRIPES{64};
+
+      bool find(const hash128_t &key, entry_t &entry);
+      void store(const hash128_t &key, const entry_t &entry);
+
+      void rank_guesses(
+                          const vector<uint32_t> &candidates,
+                          vector<uint32_t> &guesses
+                       ) const;
+
+      my_uint_t solve(
+                        const vector<uint32_t> &candidates,
+                        my_uint_t rounds_left,
+                        my_uint_t bound
+                     );
+
+      my_uint_t guess_total(
+                              const vector<uint32_t> &candidates,
+                              uint32_t guess_index,
+                              my_uint_t rounds_left,
+                              my_uint_t bound
+                           );
+
+      const pattern_matrix_t &pattern_matrix;
+      const my_uint_t width;
+      const nlog2n_table_t nlog2n;
+
+      array<stripe_t, NUM_STRIPES> stripes;
+      atomic<my_uint_t> nodes_expanded;
+};
+
+#endif
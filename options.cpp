@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "opener_ranking.h"
+#include "options.h"
+#include "scoring_policy.h"
+
+namespace
+{
+   bool parse_count(const string &arg, my_uint_t &count);
+   void print_usage(const string &program_name);
+}
+
+bool parse_options(int argc, char *argv[], options_t &options)
+{
+   const vector<string> args(argv + 1, argv + argc);
+   vector<string> positional;
+   bool rounds_given{false};
+   bool word_lists_given{false};
+   bool shard_given{false};
+
+   for (my_uint_t i{0}; i < args.size(); ++i)
+   {
+      const string &arg{args[i]};
+
+      if (arg == "--batch")
+         options.batch = true;
+      else if (arg == "--openers")
+         options.print_openers = true;
+      else if (arg == "--guess-cache")
+         options.persist_guess_cache = true;
+      else if (arg == "--output" && i + 1 < args.size())
+         options.results_filename = args[++i];
+      else if (arg == "--build-tree" && i + 1 < args.size())
+         options.build_tree_filename = args[++i];
+      else if (arg == "--play-tree" && i + 1 < args.size())
+         options.play_tree_filename = args[++i];
+      else if (arg == "--serve" && i + 1 < args.size())
+         options.socket_path = args[++i];
+      else if (arg == "--telemetry" && i + 1 < args.size() && TELEMETRY_ENABLED)
+         options.telemetry_filename = args[++i];
+      else if (arg == "--rank-openers" && i + 1 < args.size())
+         options.rank_openers_filename = args[++i];
+      else if (arg == "--shard" && i + 1 < args.size())
+      {
+         if (! parse_shard(args[++i], options.shard))
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+
+         shard_given = true;
+      }
+      else if (arg == "--merge" && i + 1 < args.size())
+         options.merge_filename = args[++i];
+      else if (arg == "--compile-dictionary" && i + 1 < args.size())
+         options.compile_dictionary_filename = args[++i];
+      else if (arg == "--dictionary" && i + 1 < args.size())
+         options.parameters.dictionary_filename = args[++i];
+      else if (arg == "--guesses" && i + 1 < args.size())
+      {
+         options.parameters.allowed_guesses_filename = args[++i];
+         word_lists_given = true;
+      }
+      else if (arg == "--answers" && i + 1 < args.size())
+      {
+         options.parameters.allowed_answers_filename = args[++i];
+         word_lists_given = true;
+      }
+      else if (arg == "--rounds" && i + 1 < args.size())
+      {
+         if (
+               ! parse_count(args[++i], options.parameters.rounds) ||
+               options.parameters.rounds == 0
+            )
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+
+         rounds_given = true;
+      }
+      else if (arg == "--boards" && i + 1 < args.size())
+      {
+         if (! parse_count(args[++i], options.num_boards) || options.num_boards < 2)
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+      }
+      else if (arg == "--threads" && i + 1 < args.size())
+      {
+         if (
+               ! parse_count(args[++i], options.parameters.threads_limit) ||
+               options.parameters.threads_limit == 0
+            )
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+      }
+      else if (arg == "--memory-budget" && i + 1 < args.size())
+      {
+         if (
+               ! parse_count(args[++i], options.parameters.memory_budget) ||
+               options.parameters.memory_budget == 0 ||
+               options.parameters.memory_budget > numeric_limits<my_uint_t>::max() / (1024 * 1024)
+            )
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+
+         options.parameters.memory_budget *= 1024 * 1024;
+      }
+      else if (arg == "--manual")
+         options.parameters.manual_mode = true;
+      else if (arg == "--optimal")
+         options.strategy.optimal = true;
+      else if (arg == "--optimal-width" && i + 1 < args.size())
+      {
+         if (! parse_count(args[++i], options.strategy.optimal_width))
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+      }
+      else if (arg == "--lookahead" && i + 1 < args.size())
+      {
+         if (! parse_count(args[++i], options.strategy.lookahead_depth))
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+      }
+      else if (arg == "--lookahead-width" && i + 1 < args.size())
+      {
+         if (
+               ! parse_count(args[++i], options.strategy.lookahead_width) ||
+               options.strategy.lookahead_width == 0
+            )
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+      }
+      else if (arg == "--policy" && i + 1 < args.size())
+      {
+         if (! parse_scoring_policy(args[++i], options.strategy.policy))
+         {
+            print_usage(argv[0]);
+            return false;
+         }
+      }
+      else if (arg.starts_with("-"))
+      {
+         print_usage(argv[0]);
+         return false;
+      }
+      else
+         positional.push_back(arg);
+   }
+
+   const my_uint_t num_modes(
+                               options.batch +
+                               ! options.build_tree_filename.empty() +
+                               ! options.play_tree_filename.empty() +
+                               ! options.socket_path.empty() +
+                               (options.num_boards > 1) +
+                               ! options.compile_dictionary_filename.empty() +
+                               options.print_openers +
+                               ! options.rank_openers_filename.empty() +
+                               ! options.merge_filename.empty()
+                            );
+
+   // Merging takes every other argument as a partial file
+   if (! options.merge_filename.empty())
+   {
+      if (num_modes > 1 || positional.empty())
+      {
+         print_usage(argv[0]);
+         return false;
+      }
+
+      options.merge_partial_filenames = positional;
+
+      return true;
+   }
+
+   if (
+         (positional.size() > 1 && options.num_boards == 1) ||
+         (! positional.empty() && positional.size() != options.num_boards) ||
+         num_modes > 1 ||
+         (! options.build_tree_filename.empty() && ! positional.empty()) ||
+         (! options.socket_path.empty() && ! positional.empty()) ||
+         (! options.compile_dictionary_filename.empty() && ! positional.empty()) ||
+         (options.print_openers && ! positional.empty()) ||
+         (! options.rank_openers_filename.empty() && ! positional.empty()) ||
+         (shard_given && options.rank_openers_filename.empty()) ||
+         (! options.parameters.dictionary_filename.empty() && word_lists_given)
+      )
+   {
+      print_usage(argv[0]);
+      return false;
+   }
+
+   // Each extra board gets one more round, as in Quordle and Octordle
+   if (options.num_boards > 1 && ! rounds_given)
+      options.parameters.rounds = options.num_boards + 5;
+
+   if (options.num_boards > 1)
+      options.board_targets = positional;
+   else if (positional.size() == 1)
+   {
+      if (options.batch)
+         options.batch_targets_filename = positional[0];
+      else
+         options.target_word = positional[0];
+   }
+
+   return true;
+}
+
+namespace
+{
+   bool parse_count(const string &arg, my_uint_t &count)
+   {
+      if (arg.empty() || ! all_of(arg.cbegin(), arg.cend(), ::isdigit))
+         return false;
+
+      // Fails on numbers too large for count
+      const from_chars_result parsed{from_chars(arg.data(), arg.data() + arg.size(), count)};
+
+      return parsed.ec == errc{};
+   }
+
+   void print_usage(const string &program_name)
+   {
+      cout << "Usage: " << program_name << " [<target word>]" << endl;
+      cout << "   If a target word is supplied, result calculations" << endl;
+      cout << "   will be performed automatically. Otherwise, the" << endl;
+      cout << "   user will have to enter them manually." << endl;
+      cout << endl;
+
+      cout << "       " << program_name
+           << " --batch [<targets file>] [--output <results file>]" << endl;
+      cout << "   Play every word in the targets file (by default, every" << endl;
+      cout << "   allowed answer) in one process and write the number of" << endl;
+      cout << "   rounds each took to the results file (by default," << endl;
+      cout << "   results_sorted.txt)." << endl;
+      cout << endl;
+
+      cout << "       " << program_name << " --build-tree <tree file>" << endl;
+      cout << "   Expand the complete solving strategy into a decision" << endl;
+      cout << "   tree and save it to the tree file." << endl;
+      cout << endl;
+
+      cout << "       " << program_name
+           << " --play-tree <tree file> [<target word>]" << endl;
+      cout << "   Play a game by following a saved decision tree, with" << endl;
+      cout << "   no entropy calculations at all." << endl;
+      cout << endl;
+
+      cout << "       " << program_name
+           << " --boards <boards> [<target word> ...]" << endl;
+      cout << "   Solve several puzzles at once with the same guesses, as" << endl;
+      cout << "   in Quordle or Octordle, with one target word per board" << endl;
+      cout << "   or results entered manually. Each guess is chosen for" << endl;
+      cout << "   the most information over all unsolved boards. There" << endl;
+      cout << "   are boards + 5 rounds unless --rounds is given." << endl;
+      cout << endl;
+
+      cout << "       " << program_name << " --serve <socket path>" << endl;
+      cout << "   Load everything once, then serve any number of game" << endl;
+      cout << "   sessions at once over a Unix domain socket, one" << endl;
+      cout << "   request per line: new, guess <session>," << endl;
+      cout << "   submit <session> <word> <result>, end <session>," << endl;
+      cout << "   stats and shutdown." << endl;
+      cout << endl;
+
+      cout << "   Every mode except --play-tree also accepts" << endl;
+      cout << "   --guesses <file> and --answers <file>, the word lists to" << endl;
+      cout << "   use (by default, "
+           << parameters_t{}.allowed_guesses_filename
+           << " and" << endl;
+      cout << "   "
+           << parameters_t{}.allowed_answers_filename
+           << "). Words may have "
+           << MIN_WORD_LENGTH
+           << " to "
+           << MAX_WORD_LENGTH
+           << " letters." << endl;
+      cout << endl;
+
+      cout << "       " << program_name
+           << " --compile-dictionary <image file>" << endl;
+      cout << "   Compile the word lists into a binary image that any" << endl;
+      cout << "   mode except --play-tree can map with --dictionary" << endl;
+      cout << "   <image file>, in place of --guesses and --answers, to" << endl;
+      cout << "   start up without reading and sorting the lists." << endl;
+      cout << endl;
+
+      cout << "       " << program_name << " --openers" << endl;
+      cout << "   Print the best first guesses by average rounds and by" << endl;
+      cout << "   two-ply entropy, then every allowed guess ranked by" << endl;
+      cout << "   entropy as a first guess." << endl;
+      cout << "   The table is built once for each pair of word lists" << endl;
+      cout << "   and cached on disk; the first guess is taken from it." << endl;
+      cout << endl;
+
+      cout << "       " << program_name
+           << " --rank-openers <partial file> [--shard <index>/<count>]" << endl;
+      cout << "   Rank first guesses by the average rounds of a game" << endl;
+      cout << "   against every allowed answer. The work can be split" << endl;
+      cout << "   into count shards, run as separate processes on any" << endl;
+      cout << "   machines sharing a filesystem, each ranking every" << endl;
+      cout << "   count-th guess. Each writes its own partial file as it" << endl;
+      cout << "   goes, and picks up where it left off if rerun." << endl;
+      cout << endl;
+
+      cout << "       " << program_name
+           << " --merge <ranking file> <partial file> ..." << endl;
+      cout << "   Check that the partial files are every shard of the" << endl;
+      cout << "   same ranking of these word lists, each complete, and" << endl;
+      cout << "   write the ranking of every first guess, best first, to" << endl;
+      cout << "   the ranking file." << endl;
+      cout << endl;
+
+      cout << "   Every mode also accepts --rounds <rounds> (by default, "
+           << parameters_t{}.rounds
+           << ")" << endl;
+      cout << "   and --threads <limit>. The single game mode also" << endl;
+      cout << "   accepts --manual, which prompts for every guess, with" << endl;
+      cout << "   the recommended guess used if none is entered." << endl;
+      cout << endl;
+
+      if constexpr (TELEMETRY_ENABLED)
+      {
+         cout << "   Every mode except --play-tree also accepts" << endl;
+         cout << "   --telemetry <file>, which writes a JSON line for each" << endl;
+         cout << "   round of each game to the file: where its time went," << endl;
+         cout << "   the guesses scored, the possible answers, the results" << endl;
+         cout << "   the guess could get, thread pool busy and idle time" << endl;
+         cout << "   and, if the system allows it, cycles and cache misses." << endl;
+         cout << endl;
+      }
+
+      cout << "   Every mode except --play-tree also accepts --guess-cache," << endl;
+      cout << "   which reuses best guesses saved to disk by earlier runs" << endl;
+      cout << "   and saves any new ones." << endl;
+      cout << endl;
+
+      cout << "   Every mode except --play-tree also accepts" << endl;
+      cout << "   --policy <measure>[=<weight>],..., which scores guesses" << endl;
+      cout << "   by a weighted sum of entropy, expected-size (the" << endl;
+      cout << "   expected number of possible answers left), worst-case" << endl;
+      cout << "   (the most left by any result) and buckets (the number" << endl;
+      cout << "   of different results). Weights default to 1; the" << endl;
+      cout << "   default policy is entropy. Smaller sizes are better." << endl;
+      cout << endl;
+
+      cout << "   Every mode except --play-tree also accepts" << endl;
+      cout << "   --memory-budget <MiB>, for word lists too large for" << endl;
+      cout << "   the result of every guess against every answer to be" << endl;
+      cout << "   kept. If it would take more than half the budget, the" << endl;
+      cout << "   results are computed as they are needed instead, in" << endl;
+      cout << "   cache-sized tiles, or one guess at a time if the budget" << endl;
+      cout << "   is too small for a tile per thread. --lookahead," << endl;
+      cout << "   --optimal and --boards need every result kept." << endl;
+      cout << endl;
+
+      cout << "   Every mode except --play-tree also accepts" << endl;
+      cout << "   --lookahead <depth> [--lookahead-width <width>], which" << endl;
+      cout << "   picks each guess by searching depth guesses ahead over" << endl;
+      cout << "   the width (by default, 10) best guesses by entropy," << endl;
+      cout << "   minimizing the expected number of guesses." << endl;
+      cout << endl;
+
+      cout << "   Every mode except --play-tree also accepts" << endl;
+      cout << "   --optimal [--optimal-width <width>], which picks each" << endl;
+      cout << "   guess by an exhaustive search for the fewest expected" << endl;
+      cout << "   guesses within the rounds left. With a width, only that" << endl;
+      cout << "   many of the best guesses by entropy are tried at each" << endl;
+      cout << "   step, which is much faster but no longer guaranteed" << endl;
+      cout << "   optimal. Use it with --build-tree to save the optimal" << endl;
+      cout << "   tree and report its average rounds." << endl;
+
+      cout << endl;
+   }
+}
@@ -0,0 +1,76 @@
+#ifndef OPTIONS_INCLUDED
+#define OPTIONS_INCLUDED
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "opener_ranking.h"
+#include "parameters.h"
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// What the user asked for on the command line
+struct options_t
+{
+   // Single game mode: solve for this word automatically, or prompt
+   // for results if it is empty.
+   string target_word;
+
+   // Batch mode: play every word in batch_targets_filename (or every
+   // allowed answer if it is empty) and write the rounds each took
+   // to results_filename.
+   bool batch{false};
+   string batch_targets_filename;
+   string results_filename{"results_sorted.txt"};
+
+   // Load best guesses worked out by earlier runs from an on-disk
+   // cache, and save the ones worked out by this run to it.
+   bool persist_guess_cache{false};
+
+   strategy_t strategy;
+
+   // Word lists, rounds, manual mode and the thread limit
+   parameters_t parameters;
+
+   // Decision tree modes: expand the solver's whole strategy into a
+   // tree file, or play a game using a previously built tree file.
+   string build_tree_filename;
+   string play_tree_filename;
+
+   // Daemon mode: serve game sessions over a Unix domain socket
+   string socket_path;
+
+   // Multi-board mode (Quordle, Octordle...) when num_boards > 1:
+   // solve for these words automatically, one per board, or prompt for
+   // results if there are none.
+   my_uint_t num_boards{1};
+   vector<string> board_targets;
+
+   // Write a JSON line describing each round of each game to this
+   // file, if it is not empty
+   string telemetry_filename;
+
+   // Compile the word lists into a dictionary image, which --dictionary
+   // can then map instead of reading the lists
+   string compile_dictionary_filename;
+
+   // Print every allowed guess ranked as a first guess
+   bool print_openers{false};
+
+   // Rank every allowed guess in the shard as a first guess by playing
+   // every answer after it, writing the results to this file
+   string rank_openers_filename;
+   shard_t shard;
+
+   // Merge these partial files from --rank-openers into a ranking of
+   // every first guess, written to merge_filename
+   string merge_filename;
+   vector<string> merge_partial_filenames;
+};
+
+// Returns false, after printing usage, if the arguments are invalid
+bool parse_options(int argc, char *argv[], options_t &options);
+
+#endif
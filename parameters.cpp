@@ -0,0 +1,28 @@
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+#include "parameters.h"
+
+parameters_t parameters;
+
+void parameters_t::set_word_length(my_uint_t word_length)
+{
+   if (word_length < MIN_WORD_LENGTH || word_length > MAX_WORD_LENGTH)
+   {
+      stringstream ss;
+
+      ss << "Words must have "
+         << MIN_WORD_LENGTH
+         << " to "
+         << MAX_WORD_LENGTH
+         << " letters, not "
+         << word_length;
+
+      throw runtime_error(ss.str());
+   }
+
+   this->word_length = word_length;
+   num_patterns = num_patterns_for(word_length);
+}
@@ -3,33 +3,154 @@
 
 #include <cstddef>
 #include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 using namespace std;
 
 #include "type_aliases.h"
 
-constexpr my_uint_t ROUNDS{6};
-constexpr my_uint_t WORD_LENGTH{5};
+// Word lengths the solver is built for. The core kernels are compiled
+// once for each of these, with the length as a constant, and the one
+// matching the word lists is chosen at run time.
+constexpr my_uint_t MIN_WORD_LENGTH{4};
+constexpr my_uint_t MAX_WORD_LENGTH{8};
 
-// Specify whether the recommended guess should be used automatically
-// or if the user should be prompted to enter a guess. This is useful
-// when solving multiple puzzles simultaneously.
-constexpr bool MANUAL_MODE{false};
+// Each square of a result is one of three colors, so a whole result
+// can be encoded as a base-3 number with word_length digits.
+constexpr my_uint_t num_patterns_for(my_uint_t word_length)
+{
+   my_uint_t num_patterns{1};
 
-// This allows the user to set a limit on the number of threads.
-constexpr my_uint_t THREADS_LIMIT{numeric_limits<my_uint_t>::max()};
-// constexpr my_uint_t THREADS_LIMIT{<your desired value>};
+   for (my_uint_t i{0}; i < word_length; ++i)
+      num_patterns *= 3;
+
+   return num_patterns;
+}
+
+constexpr my_uint_t MAX_NUM_PATTERNS{num_patterns_for(MAX_WORD_LENGTH)};
+
+static_assert(
+                MAX_NUM_PATTERNS - 1 <= numeric_limits<pattern_t>::max(),
+                "pattern_t is too narrow for MAX_WORD_LENGTH"
+             );
+
+// Settings chosen on the command line. They are set once, before any
+// words are loaded or threads started, and never change after that.
+struct parameters_t
+{
+   my_uint_t rounds{6};
+
+   // Taken from the word lists when they are loaded. Use
+   // set_word_length() so that num_patterns stays in step.
+   my_uint_t word_length{5};
+   my_uint_t num_patterns{num_patterns_for(5)};
+
+   // Specify whether the recommended guess should be used automatically
+   // or if the user should be prompted to enter a guess. This is useful
+   // when solving multiple puzzles simultaneously.
+   bool manual_mode{false};
+
+   // This allows the user to set a limit on the number of threads.
+   my_uint_t threads_limit{numeric_limits<my_uint_t>::max()};
+
+   string allowed_guesses_filename{"wordle-allowed-guesses.txt"};
+   string allowed_answers_filename{"wordle-answers-alphabetical.txt"};
+
+   // Bytes that the pattern matrix, and copies of parts of it, may
+   // take up, or 0 for no limit
+   my_uint_t memory_budget{0};
+
+   // A dictionary image to map instead of reading the word lists above,
+   // which are then set to the names of the lists it was compiled from
+   string dictionary_filename;
+
+   // Throws if word_length is not one the solver is built for
+   void set_word_length(my_uint_t word_length);
+};
+
+extern parameters_t parameters;
+
+// Call f.template operator()<WORD_LENGTH>() with WORD_LENGTH equal to
+// word_length, so that f is compiled separately for every supported
+// word length with WORD_LENGTH a constant. For example:
+//
+//    with_word_length(
+//                       parameters.word_length,
+//                       [&]<my_uint_t WORD_LENGTH>(){ ... }
+//                    );
+template <typename function_t>
+decltype(auto) with_word_length(my_uint_t word_length, function_t &&f)
+{
+   switch (word_length)
+   {
+      case 4: return f.template operator()<4>();
+      case 5: return f.template operator()<5>();
+      case 6: return f.template operator()<6>();
+      case 7: return f.template operator()<7>();
+      case 8: return f.template operator()<8>();
+   }
+
+   stringstream ss;
+
+   ss << "Unsupported word length " << word_length;
+   throw runtime_error(ss.str());
+}
+
+static_assert(
+                MIN_WORD_LENGTH == 4 && MAX_WORD_LENGTH == 8,
+                "with_word_length() must handle every supported word length"
+             );
 
 // Save filtered word lists to disk after each round
 constexpr bool DEBUG_MODE{false};
 
-// To save a few seconds at program start, a hard-coded first
-// guess can be used.
-constexpr bool USE_HARDCODED_FIRST_GUESS{true};
+// Allow per-round telemetry with --telemetry. When false, every bit of
+// it is compiled out of the hot paths.
+constexpr bool TELEMETRY_ENABLED{true};
+
+// Take the first guess from a table of the best first guesses for the
+// word lists, built once and cached on disk in the current directory
+// under this prefix followed by a hash of the word lists. The best
+// OPENER_TWO_PLY_WIDTH by entropy are ranked by two-ply entropy too,
+// the best OPENER_ROUNDS_WIDTH of those by the average rounds of a
+// game against every answer, and the best of those is used.
+constexpr bool USE_OPENER_TABLE{true};
+constexpr my_uint_t OPENER_TWO_PLY_WIDTH{16};
+constexpr my_uint_t OPENER_ROUNDS_WIDTH{8};
+const string opener_table_prefix{"opener_table_"};
+
+// The guess x answer pattern matrix is cached on disk, in the current
+// directory, under this prefix followed by a hash of the word lists.
+const string pattern_matrix_cache_prefix{"pattern_matrix_"};
+
+// The pattern matrix is only built if it fits in half the memory
+// budget, if there is one. Otherwise scoring computes patterns a tile
+// at a time, each tile's candidates' letters and its guesses'
+// histograms sized to stay in a cache of this many bytes together.
+constexpr my_uint_t PATTERN_TILE_BYTES{256 * 1024};
+constexpr my_uint_t MAX_GUESSES_PER_TILE{64};
+
+// While the user enters the result of a guess, the next guess is
+// worked out in the background for at most this many of the results
+// it can get, most likely first
+constexpr my_uint_t MAX_SPECULATIVE_RESULTS{64};
+
+// The daemon drops a session that has had no requests for this many
+// seconds, so that clients that go away without ending their sessions
+// do not keep their games forever
+constexpr my_uint_t DAEMON_SESSION_IDLE_SECONDS{30 * 60};
+
+// The daemon answers a request line longer than this many bytes with
+// an error and closes the connection, rather than buffering it
+constexpr my_uint_t DAEMON_MAX_REQUEST_LENGTH{4096};
 
-const string allowed_guesses_filename{"wordle-allowed-guesses.txt"};
-const string allowed_answers_filename{"wordle-answers-alphabetical.txt"};
-// const string allowed_guesses_filename{"wordmaster-allowed-guesses.txt"};
-// const string allowed_answers_filename{"wordmaster-answers-alphabetical.txt"};
+// Best guesses already worked out for a game state are remembered in
+// a cache of at most this many entries. With --guess-cache, the cache
+// is also saved in the current directory under this prefix followed
+// by a hash of the word lists, and reused by later runs.
+constexpr my_uint_t GUESS_CACHE_MAX_ENTRIES{1 << 20};
+const string guess_cache_prefix{"guess_cache_"};
 
 #endif
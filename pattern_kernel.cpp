@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <array>
+
+#include <immintrin.h>
+
+using namespace std;
+
+#include "pattern_kernel.h"
+#include "pattern_matrix.h"
+
+namespace
+{
+   // Chosen once, based on what the CPU we are running on supports
+   const bool use_avx2{__builtin_cpu_supports("avx2") != 0};
+}
+
+template <my_uint_t WORD_LENGTH>
+void pattern_kernel_t<WORD_LENGTH>::compute_patterns(
+                                                      const char *guess,
+                                                      const letter_columns_t &answers,
+                                                      my_uint_t first,
+                                                      my_uint_t num_answers,
+                                                      pattern_t *patterns
+                                                   )
+{
+   (use_avx2 ? compute_patterns_avx2 : compute_patterns_scalar)(
+                                                                  guess,
+                                                                  answers,
+                                                                  first,
+                                                                  num_answers,
+                                                                  patterns
+                                                               );
+}
+
+template <my_uint_t WORD_LENGTH>
+void pattern_kernel_t<WORD_LENGTH>::compute_patterns_scalar(
+                                                             const char *guess,
+                                                             const letter_columns_t &answers,
+                                                             my_uint_t first,
+                                                             my_uint_t num_answers,
+                                                             pattern_t *patterns
+                                                          )
+{
+   array<char, WORD_LENGTH> answer;
+
+   for (my_uint_t n{0}; n < num_answers; ++n)
+   {
+      for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+         answer[i] = answers.column(i)[first + n];
+
+      patterns[n] = compute_pattern<WORD_LENGTH>(answer.data(), guess);
+   }
+}
+
+template <my_uint_t WORD_LENGTH>
+__attribute__((target("avx2")))
+void pattern_kernel_t<WORD_LENGTH>::compute_patterns_avx2(
+                                                           const char *guess,
+                                                           const letter_columns_t &answers,
+                                                           my_uint_t first,
+                                                           my_uint_t num_answers,
+                                                           pattern_t *patterns
+                                                        )
+{
+   // One answer in each byte lane. A square that is not green is
+   // yellow if the answer has more copies of its letter outside the
+   // green squares than there are squares before it in the guess with
+   // the same letter that are not green either: each of those has
+   // used up a copy, if there was one left. So for answer abcda and
+   // guess azaza, the middle a is black. Counting both sides needs no
+   // loop over duplicates, and which squares of the guess share a
+   // letter is the same for every answer.
+   constexpr my_uint_t LANES{32};
+
+   const __m256i all_ones{_mm256_set1_epi8(-1)};
+   const __m256i ones{_mm256_set1_epi8(1)};
+   const __m256i twos{_mm256_set1_epi8(2)};
+
+   __m256i guess_letters[WORD_LENGTH];
+
+   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+      guess_letters[i] = _mm256_set1_epi8(guess[i]);
+
+   my_uint_t n{0};
+
+   for (; n + LANES <= num_answers; n += LANES)
+   {
+      __m256i letters[WORD_LENGTH];
+      __m256i green[WORD_LENGTH];
+
+      for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+      {
+         letters[i] = _mm256_loadu_si256(
+                                           reinterpret_cast<const __m256i *>(
+                                                                               answers.column(i) + first + n
+                                                                            )
+                                        );
+
+         green[i] = _mm256_cmpeq_epi8(letters[i], guess_letters[i]);
+      }
+
+      // The patterns of the first and last 16 answers, built up one
+      // base-3 digit at a time
+      __m256i low{_mm256_setzero_si256()};
+      __m256i high{_mm256_setzero_si256()};
+
+      for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+      {
+         // Counts go up by one where a mask is all ones
+         __m256i in_answer{_mm256_setzero_si256()};
+         __m256i earlier{_mm256_setzero_si256()};
+
+         for (my_uint_t j{0}; j < WORD_LENGTH; ++j)
+         {
+            const __m256i same{_mm256_cmpeq_epi8(letters[j], guess_letters[i])};
+
+            in_answer = _mm256_sub_epi8(in_answer, _mm256_andnot_si256(green[j], same));
+         }
+
+         for (my_uint_t k{0}; k < i; ++k)
+         {
+            if (guess[k] == guess[i])
+               earlier = _mm256_sub_epi8(earlier, _mm256_xor_si256(green[k], all_ones));
+         }
+
+         const __m256i yellow{
+                                _mm256_andnot_si256(
+                                                      green[i],
+                                                      _mm256_cmpgt_epi8(in_answer, earlier)
+                                                   )
+                             };
+
+         const __m256i digits{
+                                _mm256_or_si256(
+                                                  _mm256_and_si256(green[i], twos),
+                                                  _mm256_and_si256(yellow, ones)
+                                               )
+                             };
+
+         low = _mm256_add_epi16(
+                                  _mm256_add_epi16(_mm256_slli_epi16(low, 1), low),
+                                  _mm256_cvtepu8_epi16(_mm256_castsi256_si128(digits))
+                               );
+
+         high = _mm256_add_epi16(
+                                   _mm256_add_epi16(_mm256_slli_epi16(high, 1), high),
+                                   _mm256_cvtepu8_epi16(_mm256_extracti128_si256(digits, 1))
+                                );
+      }
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(patterns + n), low);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(patterns + n + LANES / 2), high);
+   }
+
+   compute_patterns_scalar(guess, answers, first + n, num_answers - n, patterns + n);
+}
+
+template class pattern_kernel_t<4>;
+template class pattern_kernel_t<5>;
+template class pattern_kernel_t<6>;
+template class pattern_kernel_t<7>;
+template class pattern_kernel_t<8>;
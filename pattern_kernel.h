@@ -0,0 +1,68 @@
+#ifndef PATTERN_KERNEL_INCLUDED
+#define PATTERN_KERNEL_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+#include "parameters.h"
+#include "type_aliases.h"
+
+// Words' letters stored letter-major, so that one SIMD register holds
+// the same letter of many words: letter i of word w is at
+// letters[i * count + w].
+struct letter_columns_t
+{
+   vector<char> letters;
+   my_uint_t count{0};
+
+   const char *column(my_uint_t i) const { return letters.data() + i * count; }
+};
+
+// The patterns of one guess against a block of answers, for words of
+// WORD_LENGTH letters. It is compiled for every supported word length;
+// use with_word_length() to pick the one for the current word lists.
+template <my_uint_t WORD_LENGTH>
+class pattern_kernel_t
+{
+   public:
+      // Write to patterns[0] to patterns[num_answers - 1] the patterns
+      // guess (WORD_LENGTH letters) gets against answers first to
+      // first + num_answers - 1 of answers. Same rules as
+      // compute_pattern(). The AVX2 version, which does 32 answers at
+      // a time, is used when the CPU supports it.
+      static void compute_patterns(
+                                     const char *guess,
+                                     const letter_columns_t &answers,
+                                     my_uint_t first,
+                                     my_uint_t num_answers,
+                                     pattern_t *patterns
+                                  );
+
+   private:
+      static void compute_patterns_scalar(
+                                            const char *guess,
+                                            const letter_columns_t &answers,
+                                            my_uint_t first,
+                                            my_uint_t num_answers,
+                                            pattern_t *patterns
+                                         );
+
+      __attribute__((target("avx2")))
+      static void compute_patterns_avx2(
+                                          const char *guess,
+                                          const letter_columns_t &answers,
+                                          my_uint_t first,
+                                          my_uint_t num_answers,
+                                          pattern_t *patterns
+                                       );
+};
+
+extern template class pattern_kernel_t<4>;
+extern template class pattern_kernel_t<5>;
+extern template class pattern_kernel_t<6>;
+extern template class pattern_kernel_t<7>;
+extern template class pattern_kernel_t<8>;
+
+#endif
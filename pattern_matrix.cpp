@@ -0,0 +1,369 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "hash.h"
+#include "parameters.h"
+#include "pattern_matrix.h"
+#include "print_mutex.h"
+#include "thread_pool.h"
+
+namespace
+{
+   // Bump this whenever the layout of the cache file changes.
+   constexpr uint32_t CACHE_VERSION{2};
+
+   constexpr char CACHE_MAGIC[8]{'W', 'S', 'P', 'A', 'T', 'M', 'A', 'T'};
+
+   struct cache_header_t
+   {
+      char magic[8];
+      uint32_t version;
+      uint32_t word_length;
+      uint64_t dictionary_hash;
+      uint64_t num_guesses;
+      uint64_t num_answers;
+   };
+}
+
+pattern_t encode_result(const string &result)
+{
+   pattern_t pattern{0};
+
+   for (my_uint_t i{0}; i < parameters.word_length; ++i)
+   {
+      pattern *= 3;
+
+      if (result[i] == 'y')
+         pattern += 1;
+      else if (result[i] == 'g')
+         pattern += 2;
+   }
+
+   return pattern;
+}
+
+string decode_pattern(pattern_t pattern)
+{
+   string result(parameters.word_length, 'b');
+
+   for (my_uint_t i{parameters.word_length}; i > 0; --i)
+   {
+      const my_uint_t digit{pattern % 3u};
+
+      result[i - 1] = digit == 0 ? 'b' : (digit == 1 ? 'y' : 'g');
+      pattern /= 3;
+   }
+
+   return result;
+}
+
+pattern_t compute_pattern(const string &answer, const string &guess)
+{
+   return with_word_length(
+                             parameters.word_length,
+                             [&]<my_uint_t WORD_LENGTH>()
+                             {
+                                return compute_pattern<WORD_LENGTH>(answer.data(), guess.data());
+                             }
+                          );
+}
+
+pattern_matrix_t::pattern_matrix_t(): dictionary{nullptr},
+                                      storage_kind{pattern_storage_t::full},
+                                      guesses_per_tile{1},
+                                      answers_per_tile{0},
+                                      patterns{nullptr},
+                                      mapping{nullptr},
+                                      mapping_size{0}
+{
+}
+
+pattern_matrix_t::~pattern_matrix_t()
+{
+   unmap();
+}
+
+void pattern_matrix_t::load(const dictionary_t &dictionary)
+{
+   unmap();
+
+   this->dictionary = &dictionary;
+   storage_kind = pattern_storage_t::full;
+
+   // Every pattern is computed from these, whether or not the matrix
+   // is built
+   const my_uint_t word_length{dictionary.word_length()};
+
+   guess_letter_data.resize(num_guesses() * word_length);
+   answer_letter_data.resize(num_answers() * word_length);
+
+   for (my_uint_t g{0}; g < num_guesses(); ++g)
+   {
+      const string word{guess_word(g)};
+
+      copy(word.cbegin(), word.cend(), guess_letter_data.begin() + g * word_length);
+   }
+
+   for (my_uint_t a{0}; a < num_answers(); ++a)
+   {
+      const string word{answer_word(a)};
+
+      copy(word.cbegin(), word.cend(), answer_letter_data.begin() + a * word_length);
+   }
+
+   vector<uint32_t> all_answers(num_answers());
+
+   iota(all_answers.begin(), all_answers.end(), 0);
+   all_answer_columns = answer_columns(all_answers);
+
+   const size_t matrix_size{num_guesses() * num_answers()};
+
+   // The other half of the budget is left for copies of the candidates'
+   // columns and for everything else
+   if (parameters.memory_budget > 0 && matrix_size * sizeof(pattern_t) > parameters.memory_budget / 2)
+   {
+      stream();
+      return;
+   }
+
+   const uint64_t dictionary_hash{dictionary.hash()};
+
+   const string filename{
+                           hashed_filename(
+                                             pattern_matrix_cache_prefix,
+                                             dictionary_hash,
+                                             ".bin"
+                                          )
+                        };
+
+   cache_header_t expected_header{};
+
+   memcpy(expected_header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+   expected_header.version = CACHE_VERSION;
+   expected_header.word_length = parameters.word_length;
+   expected_header.dictionary_hash = dictionary_hash;
+   expected_header.num_guesses = num_guesses();
+   expected_header.num_answers = num_answers();
+
+   const size_t file_size{sizeof(cache_header_t) + matrix_size * sizeof(pattern_t)};
+
+   for (my_uint_t attempt{0}; attempt < 2; ++attempt)
+   {
+      // Try to map an existing cache file
+      const int fd{open(filename.c_str(), O_RDONLY)};
+
+      if (fd >= 0)
+      {
+         struct stat st{};
+
+         if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == file_size)
+         {
+            void *p{mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0)};
+
+            if (p != MAP_FAILED)
+            {
+               if (memcmp(p, &expected_header, sizeof(cache_header_t)) == 0)
+               {
+                  close(fd);
+
+                  mapping = p;
+                  mapping_size = file_size;
+                  patterns = reinterpret_cast<const pattern_t *>(
+                                                                   static_cast<const char *>(p) +
+                                                                   sizeof(cache_header_t)
+                                                                );
+
+                  return;
+               }
+
+               munmap(p, file_size);
+            }
+         }
+
+         close(fd);
+      }
+
+      if (attempt > 0)
+         break;
+
+      // No usable cache, so build the matrix and save it. Write to a
+      // temporary file first so that a concurrent or interrupted run
+      // never sees a partial cache file.
+      {
+         lock_guard<mutex> lg{print_mutex};
+
+         cout << "Building pattern matrix cache " << filename << endl;
+      }
+
+      vector<pattern_t> built(matrix_size);
+
+      thread_pool().parallel_for(
+                                   0,
+                                   num_guesses(),
+                                   64,
+                                   [&](my_uint_t, my_uint_t first, my_uint_t last)
+                                   {
+                                      for (my_uint_t g{first}; g < last; ++g)
+                                         computed_row(g, built.data() + g * num_answers());
+                                   }
+                                );
+
+      const string temp_filename{temp_filename_for(filename)};
+      ofstream cache_file{temp_filename, ios::binary};
+
+      cache_file.write(
+                         reinterpret_cast<const char *>(&expected_header),
+                         sizeof(cache_header_t)
+                      );
+
+      cache_file.write(
+                         reinterpret_cast<const char *>(built.data()),
+                         built.size() * sizeof(pattern_t)
+                      );
+
+      cache_file.close();
+
+      if (! cache_file || rename(temp_filename.c_str(), filename.c_str()) != 0)
+      {
+         remove(temp_filename.c_str());
+
+         stringstream ss;
+
+         ss << "Unable to write " << filename;
+         throw runtime_error(ss.str());
+      }
+   }
+
+   stringstream ss;
+
+   ss << "Unable to map " << filename;
+   throw runtime_error(ss.str());
+}
+
+const pattern_t *pattern_matrix_t::row(my_uint_t guess_index, vector<pattern_t> &scratch) const
+{
+   if (materialized())
+      return row(guess_index);
+
+   scratch.resize(num_answers());
+   computed_row(guess_index, scratch.data());
+
+   return scratch.data();
+}
+
+letter_columns_t pattern_matrix_t::answer_columns(const vector<uint32_t> &answer_indices) const
+{
+   const my_uint_t word_length{dictionary->word_length()};
+   letter_columns_t columns;
+
+   columns.count = answer_indices.size();
+   columns.letters.resize(word_length * columns.count);
+
+   for (my_uint_t n{0}; n < columns.count; ++n)
+   {
+      const char *const letters{answer_letters(answer_indices[n])};
+
+      for (my_uint_t i{0}; i < word_length; ++i)
+         columns.letters[i * columns.count + n] = letters[i];
+   }
+
+   return columns;
+}
+
+pattern_t pattern_matrix_t::computed_pattern(my_uint_t guess_index, my_uint_t answer_index) const
+{
+   return with_word_length(
+                             parameters.word_length,
+                             [&]<my_uint_t WORD_LENGTH>()
+                             {
+                                return compute_pattern<WORD_LENGTH>(
+                                                                      answer_letters(answer_index),
+                                                                      guess_letters(guess_index)
+                                                                   );
+                             }
+                          );
+}
+
+void pattern_matrix_t::computed_row(my_uint_t guess_index, pattern_t *patterns) const
+{
+   with_word_length(
+                      parameters.word_length,
+                      [&]<my_uint_t WORD_LENGTH>()
+                      {
+                         pattern_kernel_t<WORD_LENGTH>::compute_patterns(
+                                                                           guess_letters(guess_index),
+                                                                           all_answer_columns,
+                                                                           0,
+                                                                           num_answers(),
+                                                                           patterns
+                                                                        );
+                      }
+                   );
+}
+
+void pattern_matrix_t::stream()
+{
+   const my_uint_t word_length{dictionary->word_length()};
+
+   // Half of a tile holds its candidates' letters and the other half
+   // its guesses' histograms. Scoring threads each need a tile, out of
+   // the half of the budget not given to the matrix.
+   const my_uint_t histogram_bytes{parameters.num_patterns * sizeof(uint32_t)};
+
+   if (num_threads() * PATTERN_TILE_BYTES <= parameters.memory_budget / 2)
+   {
+      storage_kind = pattern_storage_t::tiled;
+      guesses_per_tile = clamp(PATTERN_TILE_BYTES / 2 / histogram_bytes, my_uint_t{1}, MAX_GUESSES_PER_TILE);
+      answers_per_tile = PATTERN_TILE_BYTES / 2 / word_length;
+   }
+   else
+   {
+      storage_kind = pattern_storage_t::on_the_fly;
+      guesses_per_tile = 1;
+      answers_per_tile = num_answers();
+   }
+
+   lock_guard<mutex> lg{print_mutex};
+
+   cout << "The pattern matrix would take "
+        << num_guesses() * num_answers() * sizeof(pattern_t) / (1024 * 1024)
+        << " MiB, more than half the memory budget, so computing patterns ";
+
+   if (storage_kind == pattern_storage_t::tiled)
+   {
+      cout << "in tiles of "
+           << guesses_per_tile
+           << " guesses by "
+           << answers_per_tile
+           << " candidates"
+           << endl;
+   }
+   else
+      cout << "one guess at a time" << endl;
+}
+
+void pattern_matrix_t::unmap()
+{
+   if (mapping != nullptr)
+      munmap(mapping, mapping_size);
+
+   patterns = nullptr;
+   mapping = nullptr;
+   mapping_size = 0;
+}
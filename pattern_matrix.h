@@ -0,0 +1,182 @@
+#ifndef PATTERN_MATRIX_INCLUDED
+#define PATTERN_MATRIX_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "dictionary.h"
+#include "parameters.h"
+#include "pattern_kernel.h"
+#include "type_aliases.h"
+
+// Convert between a result string such as "bygbb" and its base-3
+// encoding. The first square is the most significant digit and
+// b, y and g are the digits 0, 1 and 2, so "ggggg" encodes as 242.
+pattern_t encode_result(const string &result);
+string decode_pattern(pattern_t pattern);
+
+// Equivalent to encode_result(compare(answer, guess)) for words of
+// WORD_LENGTH letters, but builds no strings and does no heap
+// allocation. Same rules as compare(): greens first, then yellows from
+// left to right for as long as unmatched copies of the letter remain
+// in the answer. Everything else is black.
+template <my_uint_t WORD_LENGTH>
+pattern_t compute_pattern(const char *answer, const char *guess)
+{
+   array<uint8_t, 26> unmatched_count{};
+   array<uint8_t, WORD_LENGTH> digits{};
+
+   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+   {
+      if (guess[i] == answer[i])
+         digits[i] = 2;
+      else
+         ++unmatched_count[answer[i] - 'a'];
+   }
+
+   pattern_t pattern{0};
+
+   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+   {
+      if (digits[i] == 0 && unmatched_count[guess[i] - 'a'] > 0)
+      {
+         digits[i] = 1;
+         --unmatched_count[guess[i] - 'a'];
+      }
+
+      pattern = pattern * 3 + digits[i];
+   }
+
+   return pattern;
+}
+
+// The same, for words of the current word length
+pattern_t compute_pattern(const string &answer, const string &guess);
+
+// How pattern_matrix_t holds the patterns, chosen by load() to fit
+// parameters.memory_budget
+enum class pattern_storage_t
+{
+   // The whole matrix, mapped
+   full,
+
+   // None of it: scoring computes the patterns of a tile of guesses
+   // against a tile of candidates at a time
+   tiled,
+
+   // None of it, and too little memory for a tile per thread, so
+   // scoring computes the patterns of one guess at a time
+   on_the_fly
+};
+
+// The result of every guess word against every answer word, one
+// pattern_t per (guess, answer) pair. Words are identified by their
+// guess and answer IDs in the dictionary that the matrix was built
+// from. The matrix lives in a memory-mapped cache file so that it
+// only has to be computed once per pair of word lists. If it does not
+// fit the memory budget, it is never built at all and every pattern
+// is computed from the words' letters when it is needed.
+class pattern_matrix_t
+{
+   public:
+      pattern_matrix_t();
+      ~pattern_matrix_t();
+
+      pattern_matrix_t(const pattern_matrix_t &) = delete;
+      pattern_matrix_t &operator=(const pattern_matrix_t &) = delete;
+
+      // Map the cached matrix for the dictionary's word lists, building
+      // and saving it first if no valid cache file exists, or pick a
+      // way to do without it. The dictionary must outlive the matrix.
+      void load(const dictionary_t &dictionary);
+
+      pattern_storage_t storage() const { return storage_kind; }
+
+      // Whether row() may be used
+      bool materialized() const { return patterns != nullptr; }
+
+      const dictionary_t &get_dictionary() const { return *dictionary; }
+
+      my_uint_t guess_index(const string &guess) const { return dictionary->guess_id(guess); }
+      my_uint_t answer_index(const string &answer) const { return dictionary->answer_id(answer); }
+
+      string guess_word(my_uint_t guess_index) const { return dictionary->guess_word(guess_index); }
+      string answer_word(my_uint_t answer_index) const { return dictionary->answer_word(answer_index); }
+
+      // Identifies the word lists the matrix was built from
+      uint64_t dictionary_hash() const { return dictionary->hash(); }
+
+      my_uint_t num_guesses() const { return dictionary->num_guesses(); }
+      my_uint_t num_answers() const { return dictionary->num_answers(); }
+
+      // The results of one guess against every answer
+      const pattern_t *row(my_uint_t guess_index) const
+      {
+         return patterns + guess_index * num_answers();
+      }
+
+      // The same, computed into scratch if the matrix is not
+      // materialized
+      const pattern_t *row(my_uint_t guess_index, vector<pattern_t> &scratch) const;
+
+      pattern_t pattern(my_uint_t guess_index, my_uint_t answer_index) const
+      {
+         if (patterns != nullptr)
+            return row(guess_index)[answer_index];
+
+         return computed_pattern(guess_index, answer_index);
+      }
+
+      // Each word's letters, word_length of them, with the words one
+      // after another in ID order
+      const char *guess_letters(my_uint_t guess_index) const
+      {
+         return guess_letter_data.data() + guess_index * dictionary->word_length();
+      }
+
+      const char *answer_letters(my_uint_t answer_index) const
+      {
+         return answer_letter_data.data() + answer_index * dictionary->word_length();
+      }
+
+      // The letters of the answers with these indices, for
+      // pattern_kernel_t
+      letter_columns_t answer_columns(const vector<uint32_t> &answer_indices) const;
+
+      // Without a materialized matrix, scoring computes the patterns
+      // of up to tile_guesses() guesses against up to tile_answers()
+      // candidates at a time
+      my_uint_t tile_guesses() const { return guesses_per_tile; }
+      my_uint_t tile_answers() const { return answers_per_tile; }
+
+   private:
+      void unmap();
+
+      // Choose how to score without the matrix
+      void stream();
+
+      // Write guess_index's patterns against every answer to patterns
+      void computed_row(my_uint_t guess_index, pattern_t *patterns) const;
+
+      pattern_t computed_pattern(my_uint_t guess_index, my_uint_t answer_index) const;
+
+      const dictionary_t *dictionary;
+      pattern_storage_t storage_kind;
+
+      vector<char> guess_letter_data;
+      vector<char> answer_letter_data;
+      letter_columns_t all_answer_columns;
+      my_uint_t guesses_per_tile;
+      my_uint_t answers_per_tile;
+
+      const pattern_t *patterns;
+      void *mapping;
+      size_t mapping_size;
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+#include "hash.h"
+#include "scoring_policy.h"
+
+namespace
+{
+   // Each measure's name and weight
+   using measures_t = array<pair<const char *, double scoring_policy_t::*>, 4>;
+
+   constexpr measures_t MEASURES{
+                                   {
+                                      {"entropy", &scoring_policy_t::entropy},
+                                      {"expected-size", &scoring_policy_t::expected_size},
+                                      {"worst-case", &scoring_policy_t::worst_case},
+                                      {"buckets", &scoring_policy_t::buckets}
+                                   }
+                                };
+
+   bool parse_weight(const string &text, double &weight);
+}
+
+double scoring_policy_t::score(const result_stats_t &stats, my_uint_t num_candidates) const
+{
+   const double n(num_candidates);
+   double total{0};
+
+   // With p = c / n for each result giving c candidates,
+   //    -sum(p * log2(p)) = log2(n) - sum(c * log2(c)) / n
+   if (entropy != 0)
+   {
+      const double sum_nlog2n{
+                                ldexp(
+                                        static_cast<double>(stats.sum_nlog2n),
+                                        -nlog2n_table_t::FIXED_POINT_BITS
+                                     )
+                             };
+
+      total += entropy * (log2(n) - sum_nlog2n / n);
+   }
+
+   // A candidate is left with the c - 1 others giving its result, and
+   // itself, so c on average over all of them
+   if (expected_size != 0)
+      total -= expected_size * stats.sum_squares / n;
+
+   if (worst_case != 0)
+      total -= worst_case * stats.largest;
+
+   if (buckets != 0)
+      total += buckets * stats.buckets;
+
+   return total;
+}
+
+double scoring_policy_t::best_score(my_uint_t num_candidates, my_uint_t max_results) const
+{
+   // Every measure is best when the candidates are spread as evenly as
+   // possible, and no better than if they could be split exactly
+   const my_uint_t results{max(min(max_results, num_candidates), my_uint_t{1})};
+   const double n(num_candidates);
+   const double r(results);
+
+   return entropy * log2(r) -
+          expected_size * n / r -
+          worst_case * ((num_candidates + results - 1) / results) +
+          buckets * r;
+}
+
+bool scoring_policy_t::is_entropy() const
+{
+   return entropy == 1 && expected_size == 0 && worst_case == 0 && buckets == 0;
+}
+
+string scoring_policy_t::description() const
+{
+   if (is_entropy())
+      return "entropy";
+
+   stringstream ss;
+
+   for (const auto &[name, weight] : MEASURES)
+   {
+      if (this->*weight == 0)
+         continue;
+
+      if (ss.tellp() > 0)
+         ss << ",";
+
+      ss << name << "=" << this->*weight;
+   }
+
+   return ss.str();
+}
+
+uint64_t scoring_policy_t::fingerprint() const
+{
+   uint64_t hash{0};
+
+   for (const auto &[name, weight] : MEASURES)
+      hash = mix64(hash ^ bit_cast<uint64_t>(this->*weight));
+
+   return hash;
+}
+
+bool parse_scoring_policy(const string &text, scoring_policy_t &policy)
+{
+   scoring_policy_t parsed{0, 0, 0, 0};
+   array<bool, MEASURES.size()> given{};
+   stringstream ss{text};
+   string term;
+
+   while (getline(ss, term, ','))
+   {
+      const string::size_type equals{term.find('=')};
+      const string name{term.substr(0, equals)};
+      double weight{1};
+
+      if (equals != string::npos && ! parse_weight(term.substr(equals + 1), weight))
+         return false;
+
+      const auto measure{
+                           find_if(
+                                     MEASURES.cbegin(),
+                                     MEASURES.cend(),
+                                     [&](const auto &one){ return name == one.first; }
+                                  )
+                        };
+
+      if (measure == MEASURES.cend() || given[measure - MEASURES.cbegin()])
+         return false;
+
+      given[measure - MEASURES.cbegin()] = true;
+      parsed.*(measure->second) = weight;
+   }
+
+   if (
+         text.empty() ||
+         text.back() == ',' ||
+         parsed.entropy + parsed.expected_size + parsed.worst_case + parsed.buckets <= 0
+      )
+      return false;
+
+   policy = parsed;
+
+   return true;
+}
+
+namespace
+{
+   bool parse_weight(const string &text, double &weight)
+   {
+      if (text.empty() || ! (isdigit(text.front()) || text.front() == '.'))
+         return false;
+
+      try
+      {
+         size_t length;
+
+         weight = stod(text, &length);
+
+         return length == text.size() && isfinite(weight);
+      }
+      catch (const exception &)
+      {
+         return false;
+      }
+   }
+}
@@ -0,0 +1,52 @@
+#ifndef SCORING_POLICY_INCLUDED
+#define SCORING_POLICY_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+#include "entropy_kernel.h"
+#include "type_aliases.h"
+
+// How guesses are scored: a weighted sum of measures of how well a
+// guess splits the candidates, each made so that higher is better.
+// Weights are never negative, and at least one is positive. The
+// default is plain entropy.
+struct scoring_policy_t
+{
+   // Shannon entropy of the results, in bits
+   double entropy{1};
+
+   // Minus the expected number of candidates left after the guess
+   double expected_size{0};
+
+   // Minus the most candidates any one result leaves
+   double worst_case{0};
+
+   // The number of different results
+   double buckets{0};
+
+   // The score of a guess with stats over num_candidates candidates
+   double score(const result_stats_t &stats, my_uint_t num_candidates) const;
+
+   // The highest score any guess with at most max_results different
+   // results over num_candidates candidates can get
+   double best_score(my_uint_t num_candidates, my_uint_t max_results) const;
+
+   bool is_entropy() const;
+
+   // "entropy" or, for any other policy, every nonzero weight as
+   // parse_scoring_policy() takes them
+   string description() const;
+
+   // Identifies the policy, for anything saved that depends on it
+   uint64_t fingerprint() const;
+};
+
+// Parse "<measure>[=<weight>],..." where each measure is one of
+// entropy, expected-size, worst-case and buckets and weights default
+// to 1. Returns false if text is invalid.
+bool parse_scoring_policy(const string &text, scoring_policy_t &policy);
+
+#endif
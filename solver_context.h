@@ -0,0 +1,78 @@
+#ifndef SOLVER_CONTEXT_INCLUDED
+#define SOLVER_CONTEXT_INCLUDED
+
+#include <cstdint>
+
+using namespace std;
+
+#include "dictionary.h"
+#include "filter.h"
+#include "guess_cache.h"
+#include "hash.h"
+#include "opener_table.h"
+#include "optimal_solver.h"
+#include "pattern_matrix.h"
+#include "scoring_policy.h"
+#include "type_aliases.h"
+
+// How the recommended guess is chosen
+struct strategy_t
+{
+   // When lookahead_depth > 0, pick among the lookahead_width best
+   // guesses by entropy the one needing the fewest further guesses on
+   // average, searching lookahead_depth guesses ahead. Otherwise just
+   // use the best guess by entropy.
+   my_uint_t lookahead_depth{0};
+   my_uint_t lookahead_width{10};
+
+   // When optimal is set, pick the guess needing the fewest further
+   // guesses on average by searching all the way to the end of the
+   // game, trying only the optimal_width best guesses by entropy at
+   // each step if optimal_width > 0. This overrides lookahead.
+   bool optimal{false};
+   my_uint_t optimal_width{0};
+
+   // What "best" means when neither search is used. The first guess
+   // only comes from the opener table, which is ranked with the
+   // default policy, for the default policy.
+   scoring_policy_t policy;
+
+   // Identifies the strategy, for anything saved that depends on it
+   uint64_t fingerprint() const
+   {
+      if (optimal)
+         return mix64(~optimal_width);
+
+      const uint64_t search{
+                              lookahead_depth == 0 ?
+                              0 :
+                              mix64(lookahead_depth) ^ mix64(mix64(lookahead_width))
+                           };
+
+      return policy.is_entropy() ? search : search ^ mix64(~policy.fingerprint());
+   }
+};
+
+// Everything that games share. All of it must outlive the games.
+struct solver_context_t
+{
+   const pattern_matrix_t &pattern_matrix;
+   const filter_index_t &filter_index;
+
+   // Every allowed guess and every allowed answer
+   const word_list_t &all_words;
+   const word_list_t &answers;
+
+   // Best guesses already worked out, if they are being remembered
+   guess_cache_t *guess_cache;
+
+   strategy_t strategy;
+
+   // Set when, and only when, strategy.optimal is
+   optimal_solver_t *optimal_solver;
+
+   // The first guess comes from here, if it is set
+   const opener_table_t *opener_table;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+#include "filter.h"
+#include "parameters.h"
+#include "speculator.h"
+#include "tools.h"
+
+speculator_t::speculator_t(const solver_context_t &context): context{context}
+{
+}
+
+speculator_t::~speculator_t()
+{
+   stop();
+}
+
+void speculator_t::start(const game_t &game, const string &guess)
+{
+   stop();
+
+   const pattern_matrix_t &pattern_matrix{context.pattern_matrix};
+   const my_uint_t guess_index{pattern_matrix.guess_index(guess)};
+
+   // How many possible answers give each result
+   vector<my_uint_t> counts(parameters.num_patterns, 0);
+
+   game.possible_answers().for_each(
+                                      [&](my_uint_t answer_index)
+                                      {
+                                         ++counts[pattern_matrix.pattern(guess_index, answer_index)];
+                                      }
+                                   );
+
+   // The likeliest first. Guessing the answer ends the game.
+   const pattern_t all_green(parameters.num_patterns - 1);
+   vector<pattern_t> patterns;
+
+   for (my_uint_t p{0}; p < counts.size(); ++p)
+   {
+      if (counts[p] > 0 && p != all_green)
+         patterns.push_back(p);
+   }
+
+   stable_sort(
+                 patterns.begin(),
+                 patterns.end(),
+                 [&](pattern_t a, pattern_t b){ return counts[a] > counts[b]; }
+              );
+
+   if (patterns.size() > MAX_SPECULATIVE_RESULTS)
+      patterns.resize(MAX_SPECULATIVE_RESULTS);
+
+   vector<string> results;
+
+   for (pattern_t pattern : patterns)
+      results.push_back(decode_pattern(pattern));
+
+   // Everything the thread needs is copied, so that it can safely run
+   // on after finish() returns
+   word_list_t all_words{game.allowed_guesses()};
+
+   all_words.erase(guess);
+
+   state = make_shared<shared_state_t>();
+
+   worker = thread{
+                     [
+                        &context = context,
+                        state = state,
+                        all_words = std::move(all_words),
+                        answers_before = game.possible_answers(),
+                        round = game.round() + 1,
+                        guess,
+                        results = std::move(results)
+                     ]()
+                     {
+                        for (const string &result : results)
+                        {
+                           {
+                              lock_guard<mutex> lg{state->state_mutex};
+
+                              if (state->cancelled)
+                                 return;
+
+                              state->in_progress = result;
+                           }
+
+                           // As game_t::submit() and next_guess() would
+                           word_list_t answers{answers_before};
+                           filter_t filter{context.filter_index};
+
+                           filter.filter(answers, guess, result);
+                           answers.erase(guess);
+
+                           candidate_columns_t columns{context.pattern_matrix};
+                           stringstream out;
+                           precomputed_guess_t next;
+
+                           try
+                           {
+                              get_guess(context, all_words, answers, round, next.guess, out, &columns);
+                           }
+                           catch (const exception &)
+                           {
+                              // Left for the real result to report, if it
+                              // ever comes up
+                              lock_guard<mutex> lg{state->state_mutex};
+
+                              state->in_progress.clear();
+                              state->state_changed.notify_all();
+
+                              return;
+                           }
+
+                           next.output = out.str();
+
+                           lock_guard<mutex> lg{state->state_mutex};
+
+                           state->done.emplace(result, std::move(next));
+                           state->in_progress.clear();
+                           state->state_changed.notify_all();
+                        }
+                     }
+                  };
+}
+
+bool speculator_t::finish(const string &result, precomputed_guess_t &next)
+{
+   if (state == nullptr)
+      return false;
+
+   unique_lock<mutex> lock{state->state_mutex};
+
+   state->cancelled = true;
+   state->state_changed.wait(lock, [&](){ return state->in_progress != result; });
+
+   const auto found{state->done.find(result)};
+   const bool ready{found != state->done.end()};
+
+   if (ready)
+      next = std::move(found->second);
+
+   return ready;
+}
+
+void speculator_t::stop()
+{
+   if (state != nullptr)
+   {
+      lock_guard<mutex> lg{state->state_mutex};
+
+      state->cancelled = true;
+   }
+
+   if (worker.joinable())
+      worker.join();
+
+   state.reset();
+}
@@ -0,0 +1,66 @@
+#ifndef SPECULATOR_INCLUDED
+#define SPECULATOR_INCLUDED
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+#include "game.h"
+#include "solver_context.h"
+#include "type_aliases.h"
+
+// Works out the next guess in the background while the user is still
+// entering the result of the last one, for the results that guess is
+// most likely to get: those left by the most possible answers. When
+// the real result is one of them, the next guess is ready at once.
+// Work is cancelled between game states, never in the middle of one;
+// a state being worked on when the real result comes in is finished
+// and thrown away, without holding anything up.
+class speculator_t
+{
+   public:
+      explicit speculator_t(const solver_context_t &context);
+      ~speculator_t();
+
+      speculator_t(const speculator_t &) = delete;
+      speculator_t &operator=(const speculator_t &) = delete;
+
+      // Start on the states game can be in after guess, cancelling
+      // anything left from before
+      void start(const game_t &game, const string &guess);
+
+      // Cancel whatever is left. Returns true, with the next guess for
+      // result in next, if it was worked out, first waiting for it if
+      // it is being worked out right now.
+      bool finish(const string &result, precomputed_guess_t &next);
+
+   private:
+      // Shared with the background thread, which may outlive a
+      // finish() that did not wait for it
+      struct shared_state_t
+      {
+         mutex state_mutex;
+         condition_variable state_changed;
+         bool cancelled{false};
+
+         // The result being worked on, if any
+         string in_progress;
+
+         // result --> the next guess after it
+         map<string, precomputed_guess_t> done;
+      };
+
+      // Cancel any work in progress and wait for its thread to stop
+      void stop();
+
+      const solver_context_t &context;
+      shared_ptr<shared_state_t> state;
+      thread worker;
+};
+
+#endif
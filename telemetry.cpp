@@ -0,0 +1,188 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "print_mutex.h"
+#include "telemetry.h"
+#include "thread_pool.h"
+
+bool telemetry_requested{false};
+
+thread_local round_telemetry_t *current_round_telemetry{nullptr};
+
+namespace
+{
+   mutex telemetry_mutex;
+   ofstream telemetry_file;
+   atomic<uint64_t> next_game{1};
+
+   // Hardware counters, or -1 if unavailable
+   int cycles_fd{-1};
+   int cache_misses_fd{-1};
+
+   int open_counter(uint64_t config);
+   uint64_t read_counter(int fd);
+}
+
+void open_telemetry(const string &filename)
+{
+   telemetry_file.open(filename);
+
+   if (! telemetry_file)
+   {
+      stringstream ss;
+
+      ss << "Unable to write " << filename;
+      throw runtime_error(ss.str());
+   }
+
+   telemetry_requested = true;
+
+   cycles_fd = open_counter(PERF_COUNT_HW_CPU_CYCLES);
+   cache_misses_fd = open_counter(PERF_COUNT_HW_CACHE_MISSES);
+
+   if (cycles_fd < 0 || cache_misses_fd < 0)
+   {
+      lock_guard<mutex> lg{print_mutex};
+
+      cout << "Hardware counters unavailable ("
+           << strerror(errno)
+           << "), so they are left out of the telemetry"
+           << endl;
+   }
+}
+
+uint64_t next_telemetry_game()
+{
+   return next_game++;
+}
+
+void write_round_telemetry(const round_telemetry_t &record)
+{
+   stringstream line;
+
+   line << "{\"game\": " << record.game
+        << ", \"round\": " << record.round
+        << ", \"guess\": \"" << record.guess << "\""
+        << ", \"candidates\": " << record.candidates
+        << ", \"guesses_scored\": " << record.guesses_scored
+        << ", \"buckets\": " << record.buckets
+        << ", \"wall_ns\": " << record.wall_ns;
+
+   const char *const phase_names[]{"filter_ns", "entropy_ns", "reduction_ns", "io_ns"};
+
+   static_assert(size(phase_names) == static_cast<my_uint_t>(telemetry_phase_t::num_phases));
+
+   for (my_uint_t i{0}; i < record.phase_ns.size(); ++i)
+      line << ", \"" << phase_names[i] << "\": " << record.phase_ns[i];
+
+   // A worker is idle for whatever part of the round it was not busy
+   line << ", \"threads\": [";
+
+   for (my_uint_t i{0}; i < record.busy_ns.size(); ++i)
+   {
+      line << (i > 0 ? ", " : "")
+           << "{\"busy_ns\": "
+           << record.busy_ns[i]
+           << ", \"idle_ns\": "
+           << record.wall_ns - min(record.busy_ns[i], record.wall_ns)
+           << "}";
+   }
+
+   line << "]";
+
+   if (cycles_fd >= 0 && cache_misses_fd >= 0)
+   {
+      line << ", \"cycles\": " << record.cycles
+           << ", \"cache_misses\": " << record.cache_misses;
+   }
+   else
+      line << ", \"cycles\": null, \"cache_misses\": null";
+
+   line << "}";
+
+   lock_guard<mutex> lg{telemetry_mutex};
+
+   telemetry_file << line.str() << endl;
+}
+
+void telemetry_span_t::begin(round_telemetry_t &record)
+{
+   this->record = &record;
+   previous_record = current_round_telemetry;
+   current_round_telemetry = &record;
+
+   const thread_pool_t &pool{thread_pool()};
+
+   start_busy_ns.resize(pool.size());
+
+   for (my_uint_t i{0}; i < pool.size(); ++i)
+      start_busy_ns[i] = pool.busy_ns(i);
+
+   start_cycles = read_counter(cycles_fd);
+   start_cache_misses = read_counter(cache_misses_fd);
+   start_time = chrono::steady_clock::now();
+}
+
+void telemetry_span_t::finish()
+{
+   const chrono::nanoseconds elapsed{chrono::steady_clock::now() - start_time};
+
+   record->wall_ns += elapsed.count();
+   record->cycles += read_counter(cycles_fd) - start_cycles;
+   record->cache_misses += read_counter(cache_misses_fd) - start_cache_misses;
+
+   const thread_pool_t &pool{thread_pool()};
+
+   record->busy_ns.resize(pool.size(), 0);
+
+   for (my_uint_t i{0}; i < pool.size(); ++i)
+      record->busy_ns[i] += pool.busy_ns(i) - start_busy_ns[i];
+
+   current_round_telemetry = previous_record;
+   record = nullptr;
+}
+
+namespace
+{
+   // Count config for this process and, since inherit is set, every
+   // thread it starts from now on
+   int open_counter(uint64_t config)
+   {
+      perf_event_attr attr{};
+
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = config;
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+   }
+
+   uint64_t read_counter(int fd)
+   {
+      uint64_t value{0};
+
+      if (fd >= 0 && read(fd, &value, sizeof(value)) != sizeof(value))
+         value = 0;
+
+      return value;
+   }
+}
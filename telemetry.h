@@ -0,0 +1,168 @@
+#ifndef TELEMETRY_INCLUDED
+#define TELEMETRY_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "parameters.h"
+#include "type_aliases.h"
+
+// Where the time of a round goes
+enum class telemetry_phase_t
+{
+   filter,
+   entropy,
+   reduction,
+   io,
+   num_phases
+};
+
+// Everything recorded about one round of one game
+struct round_telemetry_t
+{
+   uint64_t game{0};
+   my_uint_t round{0};
+   string guess;
+
+   // Possible answers before the guess, guesses whose entropy was
+   // scored to choose it and the number of different results it can get
+   my_uint_t candidates{0};
+   my_uint_t guesses_scored{0};
+   my_uint_t buckets{0};
+
+   // Time spent choosing the guess and taking in its result, in total
+   // and in each phase
+   uint64_t wall_ns{0};
+   array<uint64_t, static_cast<my_uint_t>(telemetry_phase_t::num_phases)> phase_ns{};
+
+   // Time each thread pool worker spent running tasks meanwhile. When
+   // games are played in parallel this includes work for other games,
+   // as do the hardware counts.
+   vector<uint64_t> busy_ns;
+
+   // Hardware counts for the whole process, when they are available
+   uint64_t cycles{0};
+   uint64_t cache_misses{0};
+};
+
+// Set by open_telemetry()
+extern bool telemetry_requested;
+
+// Only true with --telemetry. Everything below does nothing, and
+// compiles to nothing, otherwise.
+inline bool telemetry_active()
+{
+   return TELEMETRY_ENABLED && telemetry_requested;
+}
+
+// Start writing one JSON line per round to filename, and counting
+// cycles and cache misses if the system allows it. Must be called
+// before the thread pool starts, so that the counters cover its
+// threads too.
+void open_telemetry(const string &filename);
+
+// A number identifying a new game in the telemetry
+uint64_t next_telemetry_game();
+
+// Write a round's record
+void write_round_telemetry(const round_telemetry_t &record);
+
+// The record of the round the calling thread is working on, if any
+extern thread_local round_telemetry_t *current_round_telemetry;
+
+inline round_telemetry_t *telemetry_record()
+{
+   return telemetry_active() ? current_round_telemetry : nullptr;
+}
+
+// Adds the wall time, pool worker busy time and hardware counts from
+// its construction until end() (or its destruction) to record. The
+// calling thread's work meanwhile is recorded to record too.
+class telemetry_span_t
+{
+   public:
+      explicit telemetry_span_t(round_telemetry_t &record): record{nullptr}
+      {
+         if (telemetry_active())
+            begin(record);
+      }
+
+      ~telemetry_span_t() { end(); }
+
+      telemetry_span_t(const telemetry_span_t &) = delete;
+      telemetry_span_t &operator=(const telemetry_span_t &) = delete;
+
+      void end()
+      {
+         if (record != nullptr)
+            finish();
+      }
+
+   private:
+      void begin(round_telemetry_t &record);
+      void finish();
+
+      round_telemetry_t *record;
+      round_telemetry_t *previous_record;
+
+      chrono::steady_clock::time_point start_time;
+      vector<uint64_t> start_busy_ns;
+      uint64_t start_cycles;
+      uint64_t start_cache_misses;
+};
+
+// Adds the wall time from its construction to its destruction to one
+// phase of the calling thread's current round, if any
+class telemetry_timer_t
+{
+   public:
+      explicit telemetry_timer_t(telemetry_phase_t phase): record{telemetry_record()},
+                                                           phase{phase}
+      {
+         if (record != nullptr)
+            start_time = chrono::steady_clock::now();
+      }
+
+      ~telemetry_timer_t()
+      {
+         if (record != nullptr)
+            add_elapsed(chrono::steady_clock::now());
+      }
+
+      telemetry_timer_t(const telemetry_timer_t &) = delete;
+      telemetry_timer_t &operator=(const telemetry_timer_t &) = delete;
+
+      // Add the time so far to the current phase and time next_phase
+      // from now on
+      void switch_phase(telemetry_phase_t next_phase)
+      {
+         if (record != nullptr)
+         {
+            const auto now{chrono::steady_clock::now()};
+
+            add_elapsed(now);
+            start_time = now;
+         }
+
+         phase = next_phase;
+      }
+
+   private:
+      void add_elapsed(chrono::steady_clock::time_point now)
+      {
+         const chrono::nanoseconds elapsed{now - start_time};
+
+         record->phase_ns[static_cast<my_uint_t>(phase)] += elapsed.count();
+      }
+
+      round_telemetry_t *record;
+      telemetry_phase_t phase;
+      chrono::steady_clock::time_point start_time;
+};
+
+#endif
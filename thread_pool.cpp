@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+#include "parameters.h"
+#include "telemetry.h"
+#include "thread_pool.h"
+
+namespace
+{
+   const my_uint_t MAX_HW_THREADS{thread::hardware_concurrency()};
+
+   // The pool the calling thread works for, if any, and its slot
+   thread_local const thread_pool_t *current_pool{nullptr};
+   thread_local my_uint_t current_pool_slot{0};
+
+   // Tasks running on the calling thread while telemetry is active,
+   // counting ones it runs while a task of its own waits for a
+   // parallel_for()
+   thread_local my_uint_t running_tasks{0};
+}
+
+my_uint_t num_threads()
+{
+   return min(
+                {
+                   parameters.threads_limit,
+                   MAX_HW_THREADS > 0 ? MAX_HW_THREADS : 1
+                }
+             );
+}
+
+thread_pool_t::thread_pool_t(my_uint_t num_threads): queued_tasks{0},
+                                                     next_worker{0},
+                                                     stopping{false}
+{
+   for (my_uint_t i{0}; i < max(num_threads, my_uint_t{1}); ++i)
+      workers.push_back(make_unique<worker_t>());
+
+   for (my_uint_t i{0}; i < workers.size(); ++i)
+      threads.emplace_back(&thread_pool_t::worker_loop, this, i);
+}
+
+thread_pool_t::~thread_pool_t()
+{
+   {
+      lock_guard<mutex> lg{wake_mutex};
+      stopping = true;
+   }
+
+   wake.notify_all();
+
+   for (thread &one_thread : threads)
+      one_thread.join();
+}
+
+my_uint_t thread_pool_t::current_slot() const
+{
+   return current_pool == this ? current_pool_slot : size();
+}
+
+void thread_pool_t::parallel_for(
+                                   my_uint_t begin,
+                                   my_uint_t end,
+                                   my_uint_t grain,
+                                   const function<void(my_uint_t, my_uint_t, my_uint_t)> &f
+                                )
+{
+   if (begin >= end)
+      return;
+
+   grain = max(grain, my_uint_t{1});
+
+   struct job_t
+   {
+      atomic<my_uint_t> remaining;
+      mutex done_mutex;
+      condition_variable done;
+   } job;
+
+   job.remaining = (end - begin + grain - 1) / grain;
+
+   // Deal the ranges out round-robin, starting with the caller's own
+   // deque when the caller is a worker so that it starts on its own.
+   const my_uint_t slot{current_slot()};
+   my_uint_t worker{slot < size() ? slot : next_worker++ % size()};
+
+   for (my_uint_t first{begin}; first < end; first += grain)
+   {
+      const my_uint_t last{min(first + grain, end)};
+
+      push(
+             worker,
+             {
+                [this, &job, &f, first, last]()
+                {
+                   f(current_slot(), first, last);
+
+                   // Counted down under the lock, so that the caller
+                   // cannot see 0 and return while job is still in use
+                   lock_guard<mutex> lg{job.done_mutex};
+
+                   if (--job.remaining == 0)
+                      job.done.notify_all();
+                },
+                &job
+             }
+          );
+
+      worker = (worker + 1) % size();
+   }
+
+   // Help out until every range has been handled
+   while (job.remaining > 0)
+   {
+      if (run_one_task(slot, &job))
+         continue;
+
+      unique_lock<mutex> ul{job.done_mutex};
+
+      job.done.wait_for(
+                          ul,
+                          chrono::microseconds{100},
+                          [&job](){ return job.remaining == 0; }
+                       );
+   }
+
+   // Wait for the last task to let go of job before it goes out of scope
+   lock_guard<mutex> lg{job.done_mutex};
+}
+
+void thread_pool_t::submit(function<void()> task)
+{
+   const my_uint_t slot{current_slot()};
+
+   push(slot < size() ? slot : next_worker++ % size(), {std::move(task), nullptr});
+}
+
+bool thread_pool_t::run_one_task(my_uint_t slot, const void *job)
+{
+   function<void()> task;
+
+   // Own deque first (front), then steal from the others (back)
+   for (my_uint_t i{0}; i < size() && ! task; ++i)
+   {
+      const my_uint_t victim{(slot + i) % size()};
+      worker_t &w{*workers[victim]};
+      lock_guard<mutex> lg{w.tasks_mutex};
+
+      const my_uint_t num_tasks{w.tasks.size()};
+
+      for (my_uint_t j{0}; j < num_tasks; ++j)
+      {
+         const my_uint_t position{victim == slot ? j : num_tasks - 1 - j};
+
+         if (job == nullptr || w.tasks[position].job == job)
+         {
+            task = std::move(w.tasks[position].run);
+            w.tasks.erase(w.tasks.begin() + position);
+
+            break;
+         }
+      }
+   }
+
+   if (! task)
+      return false;
+
+   --queued_tasks;
+
+   // Time only the outermost task, which includes any nested ones
+   if (telemetry_active() && slot < size())
+   {
+      const bool outermost{running_tasks++ == 0};
+      const auto start_time{chrono::steady_clock::now()};
+
+      task();
+
+      const chrono::nanoseconds elapsed{chrono::steady_clock::now() - start_time};
+
+      --running_tasks;
+
+      if (outermost)
+         workers[slot]->busy_ns += elapsed.count();
+   }
+   else
+      task();
+
+   return true;
+}
+
+void thread_pool_t::push(my_uint_t worker, task_t task)
+{
+   {
+      lock_guard<mutex> lg{workers[worker]->tasks_mutex};
+      workers[worker]->tasks.push_back(std::move(task));
+   }
+
+   {
+      lock_guard<mutex> lg{wake_mutex};
+      ++queued_tasks;
+   }
+
+   wake.notify_one();
+}
+
+void thread_pool_t::worker_loop(my_uint_t slot)
+{
+   current_pool = this;
+   current_pool_slot = slot;
+
+   while (true)
+   {
+      if (run_one_task(slot))
+         continue;
+
+      unique_lock<mutex> ul{wake_mutex};
+
+      wake.wait(ul, [this](){ return stopping || queued_tasks > 0; });
+
+      if (stopping && queued_tasks == 0)
+         return;
+   }
+}
+
+thread_pool_t &thread_pool()
+{
+   static thread_pool_t pool{num_threads()};
+
+   return pool;
+}
@@ -0,0 +1,99 @@
+#ifndef THREAD_POOL_INCLUDED
+#define THREAD_POOL_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#include "type_aliases.h"
+
+// The number of threads used for parallel work, which is at most
+// parameters.threads_limit
+my_uint_t num_threads();
+
+// A fixed set of worker threads, each with its own deque of tasks.
+// Workers take tasks from the front of their own deque and, when that
+// is empty, steal from the back of the others'. Threads that wait for
+// a parallel_for() to finish run its remaining tasks too, so
+// parallel_for() may safely be called from inside another
+// parallel_for(). While waiting they run only that parallel_for()'s
+// tasks, never unrelated ones that could keep them from returning.
+class thread_pool_t
+{
+   public:
+      explicit thread_pool_t(my_uint_t num_threads);
+      ~thread_pool_t();
+
+      thread_pool_t(const thread_pool_t &) = delete;
+      thread_pool_t &operator=(const thread_pool_t &) = delete;
+
+      my_uint_t size() const { return workers.size(); }
+
+      // Index of the calling thread's slot for per-worker data: one of
+      // [0, size()) for pool workers and size() for any other thread.
+      // Per-worker data should therefore have size() + 1 entries.
+      my_uint_t current_slot() const;
+
+      // Nanoseconds worker has spent running tasks, counted only while
+      // telemetry is active
+      uint64_t busy_ns(my_uint_t worker) const
+      {
+         return workers[worker]->busy_ns;
+      }
+
+      // Call f(slot, first, last) for consecutive ranges of at most
+      // grain indices covering [begin, end) and wait for all of them.
+      void parallel_for(
+                          my_uint_t begin,
+                          my_uint_t end,
+                          my_uint_t grain,
+                          const function<void(my_uint_t, my_uint_t, my_uint_t)> &f
+                       );
+
+      // Queue a task without waiting for it
+      void submit(function<void()> task);
+
+   private:
+      struct task_t
+      {
+         function<void()> run;
+
+         // The parallel_for() the task belongs to, if any
+         const void *job;
+      };
+
+      struct worker_t
+      {
+         mutex tasks_mutex;
+         deque<task_t> tasks;
+
+         atomic<uint64_t> busy_ns{0};
+      };
+
+      // Run one queued task, only one belonging to job if job is not null
+      bool run_one_task(my_uint_t slot, const void *job = nullptr);
+      void push(my_uint_t worker, task_t task);
+      void worker_loop(my_uint_t slot);
+
+      vector<unique_ptr<worker_t>> workers;
+      vector<thread> threads;
+
+      mutex wake_mutex;
+      condition_variable wake;
+      atomic<my_uint_t> queued_tasks;
+      atomic<my_uint_t> next_worker;
+      bool stopping;
+};
+
+// The process-wide pool, created with num_threads() workers on first use
+thread_pool_t &thread_pool();
+
+#endif
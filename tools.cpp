@@ -1,186 +1,385 @@
-#include <cmath>
 #include <cstddef>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
-#include <future>
 #include <iomanip>
 #include <iostream>
-#include <mutex>
+#include <limits>
 #include <sstream>
-#include <thread>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using namespace std;
 
+#include "entropy_kernel.h"
+#include "lookahead.h"
 #include "parameters.h"
-#include "print_mutex.h"
+#include "scoring_policy.h"
+#include "telemetry.h"
+#include "thread_pool.h"
 #include "tools.h"
 
 namespace
 {
-   const my_uint_t MAX_HW_THREADS{thread::hardware_concurrency()};
-
-   const my_uint_t NUM_THREADS{
-                                 min(
-                                       {
-                                          THREADS_LIMIT,
-                                          MAX_HW_THREADS > 0 ? MAX_HW_THREADS : 1
-                                       }
-                                    )
-                              };
+   // Score bounds are only worth working out for the few best
+   constexpr my_uint_t MAX_TOP_K_FOR_BOUNDS{16};
 
-   entropy_words_map_t iterate_over_subset_of_words(
-                                                      word_list_t::const_iterator first,
-                                                      word_list_t::const_iterator last,
-                                                      const word_list_t &answers,
-                                                      my_uint_t total_item_count
-                                                   );
+   // Relative to the scores compared
+   constexpr double BOUND_MARGIN{1e-9};
+
+   // Best first: higher score, then possible answers, which might win
+   // outright, then lower guess index so that any remaining ties go to
+   // the alphabetically first word
+   struct scored_guess_t
+   {
+      double score;
+      uint32_t guess_index;
+      bool possible_answer;
+   };
+
+   bool better_guess(const scored_guess_t &a, const scored_guess_t &b);
+
+   template <my_uint_t WORD_LENGTH>
+   string compare(const string &answer, const string &guess);
+
+   // What the candidates' letters allow each square of a result to
+   // be, which bounds the number of different results a guess can get
+   struct result_bounds_t
+   {
+      // Candidates with each letter in each square
+      array<array<uint32_t, 26>, MAX_WORD_LENGTH> letter_at;
+
+      // Whether any candidate has each letter in some other square
+      array<array<bool, 26>, MAX_WORD_LENGTH> letter_elsewhere;
+   };
+
+   // Everything one call to calculate_entropies() scores with
+   struct scoring_t
+   {
+      const pattern_matrix_t &pattern_matrix;
+
+      // The guesses to score and, if their rows have been compacted,
+      // where those are in columns
+      vector<uint32_t> guess_indices;
+      vector<uint32_t> row_indices;
+      const candidate_columns_t *columns;
+
+      const vector<uint32_t> &answer_indices;
+
+      // The candidates, as guesses
+      word_list_t candidate_guesses;
+
+      // The candidates' letters, if their patterns are computed rather
+      // than read from the matrix
+      letter_columns_t candidate_letters;
+
+      const scoring_policy_t &policy;
+      my_uint_t top_k;
+
+      // Set when top_k is small enough for bounds to skip guesses
+      bool use_bounds;
+      result_bounds_t bounds;
+
+      // With top_k = 1, the lowest index found so far of a possible
+      // answer that gives every candidate a different result. That is
+      // the best score there is, so nothing after it can win.
+      mutable atomic<uint32_t> first_perfect_guess;
+   };
+
+   void make_result_bounds(
+                             const pattern_matrix_t &pattern_matrix,
+                             const vector<uint32_t> &answer_indices,
+                             result_bounds_t &bounds
+                          );
+
+   // An upper bound on the number of different results guess_index
+   // can get from the candidates
+   my_uint_t max_results(const scoring_t &scoring, my_uint_t guess_index);
+
+   // The fewest different results a guess must be able to get for its
+   // score to reach score, or close to it
+   my_uint_t min_results(const scoring_t &scoring, double score);
+
+   template <my_uint_t WORD_LENGTH>
+   void iterate_over_subset_of_words(
+                                       const scoring_t &scoring,
+                                       my_uint_t first,
+                                       my_uint_t last,
+                                       vector<scored_guess_t> &best,
+                                       my_uint_t &num_scored
+                                    );
+
+   // Count guess i of scoring.guess_indices as scored, and keep it in
+   // best if it is one of the top_k so far
+   void keep_if_better(
+                         const scoring_t &scoring,
+                         my_uint_t i,
+                         const result_stats_t &stats,
+                         vector<scored_guess_t> &best,
+                         my_uint_t &num_scored
+                      );
 }
 
 void calculate_entropies(
+                           const pattern_matrix_t &pattern_matrix,
                            const word_list_t &all_words,
                            const word_list_t &answers,
-                           entropy_words_map_t &entropies
+                           entropy_words_map_t &entropies,
+                           my_uint_t top_k,
+                           const candidate_columns_t *columns,
+                           const scoring_policy_t &policy
                         )
 {
    entropies.clear();
 
-   const my_uint_t total_item_count(all_words.size());
-   vector<future<entropy_words_map_t>> futures;
-   const my_uint_t guesses_per_thread{total_item_count / NUM_THREADS};
-
+   // The answers' columns in the pattern matrix
+   const vector<uint32_t> answer_indices{answers.ids()};
+
+   scoring_t scoring{
+                       pattern_matrix,
+                       {},
+                       {},
+                       nullptr,
+                       answer_indices,
+                       answers.as_guesses(),
+                       {},
+                       policy,
+                       top_k,
+                       false,
+                       {},
+                       numeric_limits<uint32_t>::max()
+                    };
+
+   // Guesses dropped from compacted columns give every candidate the
+   // same result, so they could never be among the best. The guesses
+   // in a class all score the same, so only the one that would win a
+   // tie between them is scored: the first possible answer, or else
+   // the first guess.
+   if (columns != nullptr && columns->compacted())
    {
-      lock_guard<mutex> lg{print_mutex};
+      vector<pair<uint32_t, uint32_t>> chosen;
 
-      for (my_uint_t i{0}; i < NUM_THREADS; ++i)
+      for (my_uint_t r{0}; r < columns->guesses().size(); ++r)
       {
-         word_list_t::const_iterator first{all_words.cbegin()};
-         advance(first, i * guesses_per_thread);
-
-         word_list_t::const_iterator last{first};
-         advance(last, guesses_per_thread);
-
-         if (i == (NUM_THREADS - 1))
-            advance(last, total_item_count % NUM_THREADS);
-
-         futures.push_back(
-                             async(
-                                     launch::async,
-                                     iterate_over_subset_of_words,
-                                     first,
-                                     last,
-                                     answers,
-                                     total_item_count
-                                  )
-                          );
-      }
-   }
+         uint32_t representative{numeric_limits<uint32_t>::max()};
 
-   for (my_uint_t i{0}; i < NUM_THREADS; ++i)
-   {
-      auto results{futures[i].get()};
-      entropies.merge(results);
-   }
-}
+         for (uint32_t guess_index : columns->members(r))
+         {
+            if (! all_words.contains(guess_index))
+               continue;
 
-string compare(const string &answer, const string &guess)
-{
-   my_uint_t chars_left_to_mark{WORD_LENGTH};
-   string rval{"*****"};
+            if (representative == numeric_limits<uint32_t>::max())
+               representative = guess_index;
+
+            if (scoring.candidate_guesses.contains(guess_index))
+            {
+               representative = guess_index;
+               break;
+            }
+         }
 
-   unordered_map<char, my_uint_t> char_count_in_answer{};
-   unordered_map<char, my_uint_t> char_count_marked{};
+         if (representative != numeric_limits<uint32_t>::max())
+            chosen.push_back({representative, r});
+      }
 
-   // Get counts of characters in answer
-   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
-      ++char_count_in_answer[answer[i]];
+      // Scoring relies on guess indices ascending
+      sort(chosen.begin(), chosen.end());
 
-   // Mark green squares
-   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
-   {
-      if (guess[i] == answer[i])
+      for (const auto &[guess_index, r] : chosen)
       {
-         rval[i] = 'g';
-         ++char_count_marked[guess[i]];
-         --chars_left_to_mark;
+         scoring.guess_indices.push_back(guess_index);
+         scoring.row_indices.push_back(r);
       }
+
+      scoring.columns = columns;
    }
 
-   // Mark squares that are definitely black
-   for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+   if (scoring.guess_indices.empty())
    {
-      if (char_count_in_answer[guess[i]] == 0)
-      {
-         rval[i] = 'b';
-         --chars_left_to_mark;
-      }
+      scoring.guess_indices = all_words.ids();
+      scoring.row_indices.clear();
+      scoring.columns = nullptr;
    }
 
-   // Mark yellow squares and remaining black squares. This can be tricky.
-   // Consider this case (with made up words):
-   // Answer            : abcda
-   // Guess             : azaza
-   // Correct response  : gbbbg
-   // Incorrect response: gbybg
-   while (chars_left_to_mark > 0)
+   // Without a matrix, the candidates' letters are gathered so that
+   // each tile of them is contiguous
+   if (scoring.columns == nullptr && ! pattern_matrix.materialized())
+      scoring.candidate_letters = pattern_matrix.answer_columns(answer_indices);
+
+   // Bounds only pay off when most guesses can be skipped
+   if (top_k <= MAX_TOP_K_FOR_BOUNDS)
    {
-      for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
-      {
-         if (rval[i] != '*')
-            continue;
+      scoring.use_bounds = true;
+      make_result_bounds(pattern_matrix, answer_indices, scoring.bounds);
+   }
 
-         char guess_char{guess[i]};
-         my_uint_t num_guess_char_marked_so_far{char_count_marked[guess_char]};
-         my_uint_t num_guess_char_to_be_marked{char_count_in_answer[guess_char]};
+   // Score small ranges of guesses as pool tasks, so that idle workers
+   // can steal work from busy ones. Each worker keeps its own top_k.
+   thread_pool_t &pool{thread_pool()};
+   vector<vector<scored_guess_t>> best_per_slot(pool.size() + 1);
+   vector<my_uint_t> scored_per_slot(pool.size() + 1, 0);
+   constexpr my_uint_t GUESSES_PER_TASK{64};
+
+   telemetry_timer_t timer{telemetry_phase_t::entropy};
+
+   pool.parallel_for(
+                       0,
+                       scoring.guess_indices.size(),
+                       GUESSES_PER_TASK,
+                       [&](my_uint_t slot, my_uint_t first, my_uint_t last)
+                       {
+                          with_word_length(
+                                             parameters.word_length,
+                                             [&]<my_uint_t WORD_LENGTH>()
+                                             {
+                                                iterate_over_subset_of_words<WORD_LENGTH>(
+                                                                                            scoring,
+                                                                                            first,
+                                                                                            last,
+                                                                                            best_per_slot[slot],
+                                                                                            scored_per_slot[slot]
+                                                                                         );
+                                             }
+                                          );
+                       }
+                    );
+
+   timer.switch_phase(telemetry_phase_t::reduction);
+
+   if (round_telemetry_t *record{telemetry_record()})
+   {
+      for (my_uint_t num_scored : scored_per_slot)
+         record->guesses_scored += num_scored;
+   }
 
-         if (num_guess_char_to_be_marked > num_guess_char_marked_so_far)
-         {
-            rval[i] = 'y';
-            ++char_count_marked[guess_char];
-            --chars_left_to_mark;
-         }
-         else
+   vector<scored_guess_t> best;
+
+   for (const auto &one_slot : best_per_slot)
+      best.insert(best.end(), one_slot.cbegin(), one_slot.cend());
+
+   sort(best.begin(), best.end(), better_guess);
+
+   if (best.size() > top_k)
+      best.resize(top_k);
+
+   // Every other guess in a kept guess's class scores the same, and
+   // may belong in the top_k too
+   if (scoring.columns != nullptr && top_k > 1)
+   {
+      for (my_uint_t i{0}, kept{best.size()}; i < kept; ++i)
+      {
+         const my_uint_t position(
+                                    lower_bound(
+                                                  scoring.guess_indices.cbegin(),
+                                                  scoring.guess_indices.cend(),
+                                                  best[i].guess_index
+                                               ) -
+                                    scoring.guess_indices.cbegin()
+                                 );
+
+         for (uint32_t guess_index : columns->members(scoring.row_indices[position]))
          {
-            rval[i] = 'b';
-            --chars_left_to_mark;
+            if (guess_index != best[i].guess_index && all_words.contains(guess_index))
+            {
+               best.push_back(
+                                {
+                                   best[i].score,
+                                   guess_index,
+                                   scoring.candidate_guesses.contains(guess_index)
+                                }
+                             );
+            }
          }
       }
+
+      sort(best.begin(), best.end(), better_guess);
+
+      if (best.size() > top_k)
+         best.resize(top_k);
    }
 
-   return rval;
+   for (const scored_guess_t &scored : best)
+      entropies.insert({scored.score, pattern_matrix.guess_word(scored.guess_index)});
+}
+
+string compare(const string &answer, const string &guess)
+{
+   return with_word_length(
+                             parameters.word_length,
+                             [&]<my_uint_t WORD_LENGTH>()
+                             {
+                                return compare<WORD_LENGTH>(answer, guess);
+                             }
+                          );
 }
 
 void get_guess(
+                 const solver_context_t &context,
                  const word_list_t &all_words_unfiltered,
                  const word_list_t &answers_filtered,
                  my_uint_t round,
-                 string &guess
+                 string &guess,
+                 ostream &out,
+                 candidate_columns_t *columns
               )
 {
-   static bool initialized {false};
-   static regex word_regex;
-
-   if (! initialized)
-   {
-      stringstream word_ss;
-
-      word_ss << "[a-z]{" << WORD_LENGTH << "}|^$";
-      word_regex = word_ss.str();
-
-      initialized = true;
-   }
+   const pattern_matrix_t &pattern_matrix{context.pattern_matrix};
+   const scoring_policy_t &policy{context.strategy.policy};
+
+   // The first guess comes from the opener table, when there is one
+   // and it ranks guesses the way the policy does
+   const bool use_opener{
+                           round == 1 &&
+                           context.opener_table != nullptr &&
+                           policy.is_entropy() &&
+                           answers_filtered.size() == context.answers.size()
+                        };
 
    if (answers_filtered.size() == 0)
       throw runtime_error("No possible answer words remain. Something is wrong!");
    else if (answers_filtered.size() == 1)
    {
-      guess = *(answers_filtered.cbegin());
+      guess = answers_filtered.word(answers_filtered.first());
 
-      cout << "Only remaining allowed answer word: "
+      telemetry_timer_t timer{telemetry_phase_t::io};
+
+      out << "Only remaining allowed answer word: "
            << guess
            << endl;
    }
-   else if (answers_filtered.size() <= (ROUNDS - round + 1))
+   else if (
+              context.optimal_solver != nullptr &&
+              ! use_opener
+           )
+   {
+      const vector<uint32_t> answer_indices{answers_filtered.ids()};
+
+      out << "Possible answers remaining: " << answers_filtered.size() << endl;
+
+      my_uint_t total_guesses;
+
+      guess = pattern_matrix.guess_word(
+                                          context.optimal_solver->best_guess(
+                                                                               answer_indices,
+                                                                               parameters.rounds - round + 1,
+                                                                               out,
+                                                                               total_guesses
+                                                                            )
+                                       );
+
+      telemetry_timer_t timer{telemetry_phase_t::io};
+
+      out << "Best guess by optimal search: "
+          << guess
+          << " ("
+          << total_guesses / static_cast<entropy_t>(answer_indices.size())
+          << " expected guesses)"
+          << endl;
+   }
+   else if (answers_filtered.size() <= (parameters.rounds - round + 1))
    {
       // This is the case where the number of possible answers
       // remaining is less than or equal to the number of guesses
@@ -190,15 +389,27 @@ void get_guess(
       // test if this yields any actual improvement, but it can't
       // hurt since we are guaranteed a win at this point.
 
-      // entropy --> word(s) with that entropy
+      // score --> word(s) with that score
       entropy_words_map_t entropies;
 
-      calculate_entropies(answers_filtered, answers_filtered, entropies);
+      calculate_entropies(
+                            pattern_matrix,
+                            answers_filtered.as_guesses(),
+                            answers_filtered,
+                            entropies,
+                            numeric_limits<my_uint_t>::max(),
+                            nullptr,
+                            policy
+                         );
       guess = entropies.cbegin()->second;
 
-      cout << "Possible answers remaining: " << answers_filtered.size() << endl;
+      telemetry_timer_t timer{telemetry_phase_t::io};
+
+      out << "Possible answers remaining: " << answers_filtered.size() << endl;
 
-      cout << "Best guesses by entropy over "
+      out << "Best guesses by "
+           << policy.description()
+           << " over "
            << answers_filtered.size()
            << " remaining possible answers: "
            << guess
@@ -209,7 +420,7 @@ void get_guess(
 
       for (const auto &[entropy, word] : entropies)
       {
-         cout  << "   "
+         out  << "   "
                << word
                << " ("
                << entropy
@@ -217,73 +428,129 @@ void get_guess(
                << endl;
       }
    }
+   else if (
+              context.strategy.lookahead_depth > 0 &&
+              ! use_opener
+           )
+   {
+      const vector<uint32_t> guess_indices{all_words_unfiltered.ids()};
+      const vector<uint32_t> answer_indices{answers_filtered.ids()};
+
+      out << "Possible answers remaining: " << answers_filtered.size() << endl;
+
+      entropy_t expected_guesses;
+
+      guess = pattern_matrix.guess_word(
+                                          lookahead_guess(
+                                                            pattern_matrix,
+                                                            guess_indices,
+                                                            answer_indices,
+                                                            context.strategy,
+                                                            out,
+                                                            expected_guesses
+                                                         )
+                                       );
+
+      telemetry_timer_t timer{telemetry_phase_t::io};
+
+      out << "Best guess by "
+          << context.strategy.lookahead_depth
+          << "-ply lookahead over the top "
+          << context.strategy.lookahead_width
+          << " guesses by entropy: "
+          << guess
+          << " ("
+          << expected_guesses
+          << " expected guesses)"
+          << endl;
+   }
    else
    {
       // entropy --> word(s) with that entropy
       entropy_words_map_t entropies;
 
-      if (round != 1 || ! USE_HARDCODED_FIRST_GUESS)
-         calculate_entropies(all_words_unfiltered, answers_filtered, entropies);
+      if (use_opener)
+      {
+         const opener_t &opener{context.opener_table->best()};
+
+         entropies.insert({opener.entropy, pattern_matrix.guess_word(opener.guess_index)});
+      }
       else
       {
-         if (allowed_answers_filename == "wordle-answers-alphabetical.txt")
+         if (columns != nullptr)
          {
-            // Best by looking at the first guess only
-            // entropies.insert({1.49060, "soare"});
+            telemetry_timer_t timer{telemetry_phase_t::filter};
 
-            // Best by looking at the first two guesses (i.e. two "ply")
-            entropies.insert({1.48184, "salet"});
+            columns->compact(answers_filtered.ids());
          }
-         else if (allowed_answers_filename == "wordmaster-answers-alphabetical.txt")
-            entropies.insert({1.91929, "tares"});
-         else
-            throw runtime_error("Unknown dictionary!");
+
+         calculate_entropies(
+                               pattern_matrix,
+                               all_words_unfiltered,
+                               answers_filtered,
+                               entropies,
+                               1,
+                               columns,
+                               policy
+                            );
       }
 
       guess = entropies.cbegin()->second;
 
-      cout << "Possible answers remaining: " << answers_filtered.size() << endl;
+      telemetry_timer_t timer{telemetry_phase_t::io};
 
-      cout << "Best guess by entropy taken over all guess words: "
-           << guess
+      out << "Possible answers remaining: " << answers_filtered.size() << endl;
+
+      if (use_opener)
+         out << "Best first guess from the opener table: ";
+      else
+         out << "Best guess by " << policy.description() << " taken over all guess words: ";
+
+      out << guess
            << " ("
            << entropies.cbegin()->first
            << ")"
            << endl;
    }
+}
 
-   // Let the user manually input the guess if that's what they want.
-   // This is useful when solving mutiple puzzles simultaneously.
-   //
-   // This must be done after the code above so that the user knows
-   // what the "best" word is so they can use it if they want to.
-   //
-   // If MANUAL_MODE == false, just use the suggested guess automatically.
-   if constexpr (MANUAL_MODE)
+void get_manual_guess(const word_list_t &all_words_unfiltered, string &guess)
+{
+   static bool initialized {false};
+   static regex word_regex;
+
+   if (! initialized)
    {
-      while (true)
-      {
-         string user_guess;
+      stringstream word_ss;
 
-         get_user_input(
-                          "Word (<Enter> to accept suggested guess)",
-                          word_regex,
-                          user_guess
-                       );
+      word_ss << "[a-z]{" << parameters.word_length << "}|^$";
+      word_regex = word_ss.str();
 
-         if (user_guess == "")
-         {
-            cout << "Suggested guess accepted: " << guess << endl;
-            break;
-         }
+      initialized = true;
+   }
 
-         if (all_words_unfiltered.find(user_guess) == all_words_unfiltered.cend())
-            cout << "Not a valid guess!" << endl << endl;
-         else
-         {
-            guess = user_guess;
-            break;
-         }
+   while (true)
+   {
+      string user_guess;
+
+      get_user_input(
+                       "Word (<Enter> to accept suggested guess)",
+                       word_regex,
+                       user_guess
+                    );
+
+      if (user_guess == "")
+      {
+         cout << "Suggested guess accepted: " << guess << endl;
+         break;
+      }
+
+      if (! all_words_unfiltered.contains(user_guess))
+         cout << "Not a valid guess!" << endl << endl;
+      else
+      {
+         guess = user_guess;
+         break;
       }
    }
 }
@@ -309,51 +576,62 @@ void get_user_input(const string &prompt, const regex &re, string &user_input)
    }
 }
 
-void load_words(word_list_t &all_words, word_list_t &answers)
+void load_words(dictionary_t &dictionary)
 {
-   all_words.clear();
-   answers.clear();
+   // A compiled image is already sorted and encoded
+   if (! parameters.dictionary_filename.empty())
+   {
+      dictionary.load_image(
+                              parameters.dictionary_filename,
+                              parameters.allowed_guesses_filename,
+                              parameters.allowed_answers_filename
+                           );
+
+      return;
+   }
+
+   vector<string> all_words;
+   vector<string> answers;
 
    // Load allowed guesses which aren't possible answers into
    // the list of all words.
-   ifstream allowed_guesses(allowed_guesses_filename);
+   ifstream allowed_guesses(parameters.allowed_guesses_filename);
 
    if (! allowed_guesses)
    {
       stringstream ss;
 
-      ss << allowed_guesses_filename << " is missing";
+      ss << parameters.allowed_guesses_filename << " is missing";
       throw runtime_error(ss.str());
    }
 
    string guess;
 
    while (getline(allowed_guesses, guess))
-      all_words.insert(guess);
+      all_words.push_back(guess);
 
    allowed_guesses.close();
 
-   // Now load possible answers into its own list as well as
-   // into the list of all words.
-   ifstream allowed_answers(allowed_answers_filename);
+   // Now load possible answers into their own list. The dictionary
+   // adds them to the list of all words.
+   ifstream allowed_answers(parameters.allowed_answers_filename);
 
    if (! allowed_answers)
    {
       stringstream ss;
 
-      ss << allowed_answers_filename << " is missing";
+      ss << parameters.allowed_answers_filename << " is missing";
       throw runtime_error(ss.str());
    }
 
    string answer;
 
    while (getline(allowed_answers, answer))
-   {
-      answers.insert(answer);
-      all_words.insert(answer);
-   }
+      answers.push_back(answer);
 
    allowed_answers.close();
+
+   dictionary.assign(std::move(all_words), std::move(answers));
 }
 
 void print_entropies(const entropy_words_map_t &entropies)
@@ -375,51 +653,328 @@ void save_word_list(const word_list_t &word_list, const string &filename)
 {
    ofstream word_list_file{filename};
 
-   for (const string &word : word_list)
-      word_list_file << word << endl;
+   word_list.for_each([&](my_uint_t id){ word_list_file << word_list.word(id) << endl; });
 
    word_list_file.close();
 }
 
 namespace
 {
-   entropy_words_map_t iterate_over_subset_of_words(
-                                                      word_list_t::const_iterator first,
-                                                      word_list_t::const_iterator last,
-                                                      const word_list_t &answers,
-                                                      my_uint_t total_item_count
-                                                   )
+   template <my_uint_t WORD_LENGTH>
+   string compare(const string &answer, const string &guess)
    {
-      entropy_words_map_t entropies{};
+      my_uint_t chars_left_to_mark{WORD_LENGTH};
+      array<char, WORD_LENGTH> rval;
+
+      rval.fill('*');
 
-      for (
-             word_list_t::const_iterator iter{first};
-             iter != last;
-             ++iter
-          )
+      // Indexed by letter, 'a' being 0
+      array<my_uint_t, 26> char_count_in_answer{};
+      array<my_uint_t, 26> char_count_marked{};
+
+      // Get counts of characters in answer
+      for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+         ++char_count_in_answer[answer[i] - 'a'];
+
+      // Mark green squares
+      for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
       {
-         const string &guess{*iter};
+         if (guess[i] == answer[i])
+         {
+            rval[i] = 'g';
+            ++char_count_marked[guess[i] - 'a'];
+            --chars_left_to_mark;
+         }
+      }
 
-         // bin --> item count in bin
-         bin_item_count_map_t bins;
+      // Mark squares that are definitely black
+      for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+      {
+         if (char_count_in_answer[guess[i] - 'a'] == 0)
+         {
+            rval[i] = 'b';
+            --chars_left_to_mark;
+         }
+      }
 
-         for (const string &answer : answers)
-            ++bins[compare(answer, guess)];
+      // Mark yellow squares and remaining black squares. This can be tricky.
+      // Consider this case (with made up words):
+      // Answer            : abcda
+      // Guess             : azaza
+      // Correct response  : gbbbg
+      // Incorrect response: gbybg
+      while (chars_left_to_mark > 0)
+      {
+         for (my_uint_t i{0}; i < WORD_LENGTH; ++i)
+         {
+            if (rval[i] != '*')
+               continue;
+
+            const my_uint_t guess_char(guess[i] - 'a');
+            my_uint_t num_guess_char_marked_so_far{char_count_marked[guess_char]};
+            my_uint_t num_guess_char_to_be_marked{char_count_in_answer[guess_char]};
+
+            if (num_guess_char_to_be_marked > num_guess_char_marked_so_far)
+            {
+               rval[i] = 'y';
+               ++char_count_marked[guess_char];
+               --chars_left_to_mark;
+            }
+            else
+            {
+               rval[i] = 'b';
+               --chars_left_to_mark;
+            }
+         }
+      }
 
-         // bin --> probability of landing in bin
-         bin_probability_map_t probabilities;
+      return string(rval.cbegin(), rval.cend());
+   }
+
+   bool better_guess(const scored_guess_t &a, const scored_guess_t &b)
+   {
+      if (a.score != b.score)
+         return a.score > b.score;
 
-         for (const auto &[bin, item_count] : bins)
-            probabilities[bin] = item_count / (entropy_t) total_item_count;
+      if (a.possible_answer != b.possible_answer)
+         return a.possible_answer;
 
-         entropy_t entropy{};
+      return a.guess_index < b.guess_index;
+   }
 
-         for (const auto &[word, prob] : probabilities)
-            entropy -= prob * log2(prob);
+   void make_result_bounds(
+                             const pattern_matrix_t &pattern_matrix,
+                             const vector<uint32_t> &answer_indices,
+                             result_bounds_t &bounds
+                          )
+   {
+      bounds = {};
+
+      for (uint32_t answer_index : answer_indices)
+      {
+         const string answer{pattern_matrix.answer_word(answer_index)};
 
-         entropies.insert({entropy, guess});
+         for (my_uint_t i{0}; i < answer.size(); ++i)
+         {
+            ++bounds.letter_at[i][answer[i] - 'a'];
+
+            for (my_uint_t j{0}; j < answer.size(); ++j)
+            {
+               if (j != i)
+                  bounds.letter_elsewhere[j][answer[i] - 'a'] = true;
+            }
+         }
       }
+   }
+
+   my_uint_t max_results(const scoring_t &scoring, my_uint_t guess_index)
+   {
+      const result_bounds_t &bounds{scoring.bounds};
+      const my_uint_t num_candidates{scoring.answer_indices.size()};
+      const dictionary_t &dictionary{scoring.pattern_matrix.get_dictionary()};
 
-      return entropies;
+      // Every square can only be green if some candidate has the
+      // guess's letter there, yellow if some candidate has it
+      // elsewhere and black unless every candidate has it there
+      my_uint_t results{1};
+
+      for (my_uint_t i{0}; i < parameters.word_length && results < num_candidates; ++i)
+      {
+         const my_uint_t letter{dictionary.guess_letter(guess_index, i)};
+
+         results *= (bounds.letter_at[i][letter] > 0) +
+                    bounds.letter_elsewhere[i][letter] +
+                    (bounds.letter_at[i][letter] < num_candidates);
+      }
+
+      return min(results, num_candidates);
+   }
+
+   my_uint_t min_results(const scoring_t &scoring, double score)
+   {
+      // The best score possible only grows with the number of results,
+      // so search for the first that reaches score, allowing a margin
+      // for rounding so that no guess that could be chosen is skipped
+      const my_uint_t num_candidates{scoring.answer_indices.size()};
+      const double target{score - BOUND_MARGIN * (1 + abs(score))};
+
+      if (scoring.policy.best_score(num_candidates, num_candidates) < target)
+         return num_candidates + 1;
+
+      my_uint_t low{1};
+      my_uint_t high{num_candidates};
+
+      while (low < high)
+      {
+         const my_uint_t middle{low + (high - low) / 2};
+
+         if (scoring.policy.best_score(num_candidates, middle) < target)
+            low = middle + 1;
+         else
+            high = middle;
+      }
+
+      return low;
+   }
+
+   template <my_uint_t WORD_LENGTH>
+   void iterate_over_subset_of_words(
+                                       const scoring_t &scoring,
+                                       my_uint_t first,
+                                       my_uint_t last,
+                                       vector<scored_guess_t> &best,
+                                       my_uint_t &num_scored
+                                    )
+   {
+      using kernel_t = entropy_kernel_t<WORD_LENGTH>;
+
+      const pattern_matrix_t &pattern_matrix{scoring.pattern_matrix};
+      const vector<uint32_t> &guess_indices{scoring.guess_indices};
+      const vector<uint32_t> &answer_indices{scoring.answer_indices};
+      const my_uint_t top_k{scoring.top_k};
+
+      static const nlog2n_table_t nlog2n{pattern_matrix.num_answers()};
+
+      typename kernel_t::histogram_t histogram;
+
+      // Without a matrix, a tile of guesses is scored at a time, each
+      // with its own histogram. Otherwise the tile is one guess.
+      const bool computed{scoring.columns == nullptr && ! pattern_matrix.materialized()};
+      const my_uint_t guesses_per_tile{computed ? pattern_matrix.tile_guesses() : 1};
+      const my_uint_t answers_per_tile{pattern_matrix.tile_answers()};
+
+      vector<typename kernel_t::sparse_histogram_t> sparse_histograms(guesses_per_tile);
+      vector<my_uint_t> tile;
+      vector<result_stats_t> tile_stats(guesses_per_tile);
+
+      // Guesses that cannot get this many results cannot beat the
+      // worst of the guesses kept, once top_k are kept
+      my_uint_t results_needed{0};
+      double results_needed_for{numeric_limits<double>::lowest()};
+
+      for (my_uint_t next{first}; next < last; )
+      {
+         tile.clear();
+
+         for (; next < last && tile.size() < guesses_per_tile; ++next)
+         {
+            // Guess indices ascend, and ties go to the lower one
+            if (guess_indices[next] > scoring.first_perfect_guess.load(memory_order_relaxed))
+            {
+               next = last;
+               break;
+            }
+
+            if (scoring.use_bounds && best.size() == top_k)
+            {
+               if (best.front().score != results_needed_for)
+               {
+                  results_needed_for = best.front().score;
+                  results_needed = min_results(scoring, results_needed_for);
+               }
+
+               if (max_results(scoring, guess_indices[next]) < results_needed)
+                  continue;
+            }
+
+            tile.push_back(next);
+         }
+
+         if (computed)
+         {
+            // Every guess in the tile against one tile of candidates
+            // at a time, so that their letters stay in cache
+            for (my_uint_t start{0}; start < answer_indices.size(); start += answers_per_tile)
+            {
+               const my_uint_t count{min(answers_per_tile, answer_indices.size() - start)};
+
+               for (my_uint_t t{0}; t < tile.size(); ++t)
+               {
+                  kernel_t::count_computed_patterns(
+                                                      pattern_matrix.guess_letters(guess_indices[tile[t]]),
+                                                      scoring.candidate_letters,
+                                                      start,
+                                                      count,
+                                                      sparse_histograms[t]
+                                                   );
+               }
+            }
+
+            for (my_uint_t t{0}; t < tile.size(); ++t)
+               tile_stats[t] = kernel_t::sparse_stats(sparse_histograms[t], nlog2n);
+         }
+         else if (! tile.empty())
+         {
+            const my_uint_t i{tile.front()};
+
+            if (scoring.columns != nullptr)
+            {
+               tile_stats.front() = kernel_t::contiguous_stats(
+                                                                 scoring.columns->row_at(scoring.row_indices[i]),
+                                                                 answer_indices.size(),
+                                                                 nlog2n,
+                                                                 sparse_histograms.front()
+                                                              );
+            }
+            else
+            {
+               kernel_t::pattern_histogram(
+                                             pattern_matrix.row(guess_indices[i]),
+                                             pattern_matrix.num_answers(),
+                                             answer_indices,
+                                             histogram
+                                          );
+
+               tile_stats.front() = kernel_t::histogram_stats(histogram, nlog2n);
+            }
+         }
+
+         for (my_uint_t t{0}; t < tile.size(); ++t)
+            keep_if_better(scoring, tile[t], tile_stats[t], best, num_scored);
+      }
+   }
+
+   void keep_if_better(
+                         const scoring_t &scoring,
+                         my_uint_t i,
+                         const result_stats_t &stats,
+                         vector<scored_guess_t> &best,
+                         my_uint_t &num_scored
+                      )
+   {
+      const vector<uint32_t> &guess_indices{scoring.guess_indices};
+      const vector<uint32_t> &answer_indices{scoring.answer_indices};
+      const my_uint_t top_k{scoring.top_k};
+
+      ++num_scored;
+
+      const scored_guess_t scored{
+                                    scoring.policy.score(stats, answer_indices.size()),
+                                    guess_indices[i],
+                                    scoring.candidate_guesses.contains(guess_indices[i])
+                                 };
+
+      if (top_k == 1 && scored.possible_answer && stats.buckets == answer_indices.size())
+      {
+         uint32_t first_perfect{scoring.first_perfect_guess.load()};
+
+         while (
+                  guess_indices[i] < first_perfect &&
+                  ! scoring.first_perfect_guess.compare_exchange_weak(first_perfect, guess_indices[i])
+               );
+      }
+
+      // best is a heap with the worst of the kept guesses on top
+      if (best.size() < top_k)
+      {
+         best.push_back(scored);
+         push_heap(best.begin(), best.end(), better_guess);
+      }
+      else if (better_guess(scored, best.front()))
+      {
+         pop_heap(best.begin(), best.end(), better_guess);
+         best.back() = scored;
+         push_heap(best.begin(), best.end(), better_guess);
+      }
    }
 }
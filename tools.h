@@ -1,30 +1,55 @@
 #ifndef TOOLS_INCLUDED
 #define TOOLS_INCLUDED
 
+#include <limits>
+#include <ostream>
 #include <regex>
 #include <string>
 
 using namespace std;
 
+#include "candidate_columns.h"
+#include "dictionary.h"
+#include "pattern_matrix.h"
+#include "scoring_policy.h"
+#include "solver_context.h"
 #include "type_aliases.h"
 
+// Score every word in all_words, a list of guesses, by how policy rates
+// its results over answers, keeping only the top_k best. Ties go to
+// possible answers, then to the lower guess index. If columns is given,
+// its candidates must be answers, and its compacted rows are read
+// instead of the pattern matrix once there are any, scoring only one
+// guess of each class of guesses that share a row.
 void calculate_entropies(
+                           const pattern_matrix_t &pattern_matrix,
                            const word_list_t &all_words,
                            const word_list_t &answers,
-                           entropy_words_map_t &entropies
+                           entropy_words_map_t &entropies,
+                           my_uint_t top_k = numeric_limits<my_uint_t>::max(),
+                           const candidate_columns_t *columns = nullptr,
+                           const scoring_policy_t &policy = scoring_policy_t{}
                         );
 
 string compare(const string &answer, const string &guess);
 
+// If columns is given, it is compacted to answers_filtered, when that
+// is worthwhile, and used for scoring.
 void get_guess(
+                 const solver_context_t &context,
                  const word_list_t &all_words_unfiltered,
                  const word_list_t &answers_filtered,
                  my_uint_t round,
-                 string &guess
+                 string &guess,
+                 ostream &out,
+                 candidate_columns_t *columns = nullptr
               );
 
+// Let the user replace the suggested guess with one of their own
+void get_manual_guess(const word_list_t &all_words_unfiltered, string &guess);
+
 void get_user_input(const string &prompt, const regex &re, string &user_input);
-void load_words(word_list_t &all_words, word_list_t &answers);
+void load_words(dictionary_t &dictionary);
 void print_entropies(const entropy_words_map_t &entropies);
 void save_word_list(const word_list_t &word_list, const string &filename);
 
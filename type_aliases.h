@@ -3,18 +3,16 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <map>
-#include <set>
 #include <string>
 
 using namespace std;
 
 using my_uint_t = long unsigned int;
 using entropy_t = long double;
-using bin_item_count_map_t = map<string, my_uint_t>;
-using bin_probability_map_t = map<string, entropy_t>;
+using pattern_t = uint16_t;
 using entropy_words_map_t = multimap<entropy_t, string, greater<entropy_t>>;
-using word_list_t = set<string>;
 
 #endif